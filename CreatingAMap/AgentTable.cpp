@@ -0,0 +1,64 @@
+#include "AgentTable.h"
+#include <algorithm>
+
+void AgentTable::clear() {
+    starts.clear();
+    goals.clear();
+    pathOffsets.assign(1, 0);
+    pathPool.clear();
+    positions.clear();
+    pathIndex.clear();
+    arrived.clear();
+}
+
+void AgentTable::reserve(int count) {
+    starts.reserve(count);
+    goals.reserve(count);
+    pathOffsets.reserve(count + 1);
+    positions.reserve(count);
+    pathIndex.reserve(count);
+    arrived.reserve(count);
+}
+
+int AgentTable::add(const Position& start, const Position& goal) {
+    starts.push_back(start);
+    goals.push_back(goal);
+    pathOffsets.push_back(pathOffsets.back());  // No path yet
+    positions.push_back(start);
+    pathIndex.push_back(1);
+    arrived.push_back(start == goal ? 1 : 0);
+    return size() - 1;
+}
+
+void AgentTable::setPaths(const std::vector<Path>& paths) {
+    size_t total = 0;
+    for (const Path& path : paths) total += path.size();
+    pathPool.clear();
+    pathPool.reserve(total);
+    const int numAgents = size();
+    for (int agent = 0; agent < numAgents; ++agent) {
+        if (agent < static_cast<int>(paths.size())) {
+            pathPool.insert(pathPool.end(), paths[agent].begin(), paths[agent].end());
+        }
+        pathOffsets[agent + 1] = static_cast<int>(pathPool.size());
+    }
+    rewind();
+}
+
+bool AgentTable::hasNextStep(int agent) const {
+    return !arrived[agent] && pathIndex[agent] < getPathLength(agent);
+}
+
+void AgentTable::advance(int agent) {
+    positions[agent] = getNextStep(agent);
+    pathIndex[agent]++;
+    if (pathIndex[agent] >= getPathLength(agent) && positions[agent] == goals[agent]) arrived[agent] = 1;
+}
+
+void AgentTable::rewind() {
+    positions = starts;
+    std::fill(pathIndex.begin(), pathIndex.end(), 1);  // path[0] is the start
+    for (int agent = 0; agent < size(); ++agent) {
+        arrived[agent] = starts[agent] == goals[agent] && getPathLength(agent) <= 1 ? 1 : 0;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include <vector>
+#include <cstdint>
+
+// Planner and simulation state of all agents, one array per field, so a pass
+// over the agents only touches the fields it needs and the planners get the
+// starts and goals without copying. Agents are addressed by index. The paths
+// are stored back to back in one pool: agent i's path is
+// pathPool[pathOffsets[i], pathOffsets[i + 1]).
+class AgentTable {
+public:
+    void clear();
+    void reserve(int count);
+    // Returns the new agent's index.
+    int add(const Position& start, const Position& goal);
+    int size() const { return static_cast<int>(starts.size()); }
+
+    const std::vector<Position>& getStarts() const { return starts; }
+    const std::vector<Position>& getGoals() const { return goals; }
+    Position getStart(int agent) const { return starts[agent]; }
+    Position getGoal(int agent) const { return goals[agent]; }
+    void setGoal(int agent, const Position& goal) { goals[agent] = goal; }
+
+    // Replaces every agent's path and puts the agents back on their starts.
+    void setPaths(const std::vector<Path>& paths);
+    int getPathLength(int agent) const { return pathOffsets[agent + 1] - pathOffsets[agent]; }
+    const Position* getPath(int agent) const { return pathPool.data() + pathOffsets[agent]; }
+    size_t getPathPoolSize() const { return pathPool.size(); }
+
+    // Simulation: an agent walks its path one entry per step, from path[1] on,
+    // and stops for good when the path ends on its goal (see PlanExecutor).
+    Position getPosition(int agent) const { return positions[agent]; }
+    void setPosition(int agent, const Position& position) { positions[agent] = position; }
+    bool hasArrived(int agent) const { return arrived[agent] != 0; }
+    // False if the agent has arrived or its path is used up.
+    bool hasNextStep(int agent) const;
+    Position getNextStep(int agent) const { return pathPool[pathOffsets[agent] + pathIndex[agent]]; }
+    void advance(int agent);
+    // Back on the starts, at the beginning of the paths.
+    void rewind();
+
+private:
+    std::vector<Position> starts;
+    std::vector<Position> goals;
+    std::vector<int> pathOffsets{ 0 };  // size() + 1 entries
+    std::vector<Position> pathPool;
+
+    std::vector<Position> positions;
+    std::vector<int> pathIndex;     // Next path entry to move to; 1 after a rewind
+    std::vector<uint8_t> arrived;
+};
@@ -0,0 +1,671 @@
+#include "CBS.h"
+#include "LowLevel.h"
+#include "ConflictDetector.h"
+#include "MDD.h"
+#include "Profiling.h"
+#include <queue>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <tuple>
+#include <cstdlib>
+
+namespace {
+    // CT nodes are never moved once stored, so children refer to their parent by
+    // pointer. Apart from 'paths', 'conflicts' and 'mdds', which the expanding
+    // thread updates and releases, a stored node is immutable and can be read by
+    // any thread.
+    struct CTNode {
+        const CTNode* parent;                 // nullptr for the root
+        std::vector<Constraint> constraints;  // Added when this node was generated, all for one agent
+        std::vector<Path> paths;
+        std::vector<Conflict> conflicts;
+        std::vector<std::shared_ptr<const MDD>> mdds;  // Per agent, built on demand; shared with the children
+        int cost;
+        int numConflicts;
+        int id;
+    };
+
+    struct CTNodeCompare {
+        bool operator()(const CTNode* a, const CTNode* b) const {
+            if (a->cost != b->cost) return a->cost > b->cost;
+            if (a->numConflicts != b->numConflicts) return a->numConflicts > b->numConflicts;
+            return a->id > b->id;
+        }
+    };
+
+    typedef std::priority_queue<CTNode*, std::vector<CTNode*>, CTNodeCompare> CTOpenList;
+
+    typedef std::chrono::steady_clock Clock;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    int sumOfCosts(const std::vector<Path>& paths) {
+        int total = 0;
+        for (const auto& path : paths) total += pathCost(path);
+        return total;
+    }
+
+    int sign(int value) {
+        return (value > 0) - (value < 0);
+    }
+
+    int manhattan(const Position& a, const Position& b) {
+        return std::abs(a.x - b.x) + std::abs(a.y - b.y);
+    }
+
+    enum ConflictClass { NON_CARDINAL, SEMI_CARDINAL, CARDINAL };
+
+    // Order among conflicts of the same class: the earliest one, ties broken by agent ids.
+    std::tuple<int, int, int> conflictKey(const Conflict& c) {
+        return std::make_tuple(c.timestep, std::min(c.agent1, c.agent2), std::max(c.agent1, c.agent2));
+    }
+
+    // The conflict to split on without classification.
+    const Conflict& selectConflict(const std::vector<Conflict>& conflicts) {
+        const Conflict* best = &conflicts.front();
+        for (const Conflict& conflict : conflicts) {
+            if (conflictKey(conflict) < conflictKey(*best)) best = &conflict;
+        }
+        return *best;
+    }
+
+    ConstraintTable collectConstraints(const CTNode* node, int agent, const ReservationTable* reservations) {
+        ConstraintTable table;
+        table.setReservations(reservations);
+        for (; node->parent != nullptr; node = node->parent) {
+            if (node->constraints.front().agent == agent) {
+                for (const Constraint& constraint : node->constraints) table.add(constraint);
+            }
+        }
+        return table;
+    }
+
+    // Everything a CT expansion needs besides per-thread scratch memory.
+    struct CBSProblem {
+        const std::vector<Position>& starts;
+        const std::vector<Position>& goals;
+        const Grid& grid;
+        HeuristicCache& heuristics;
+        const CBSOptions& options;
+    };
+
+    // MDD of the agent's paths that cost as much as its current one and satisfy
+    // the node's constraints.
+    const MDD& nodeMDD(const CBSProblem& problem, CTNode& node, int agent) {
+        std::shared_ptr<const MDD>& mdd = node.mdds[agent];
+        if (!mdd) {
+            const Grid& grid = problem.grid;
+            mdd = std::make_shared<const MDD>(buildMDD(grid, grid.toId(problem.starts[agent]),
+                *problem.heuristics.get(problem.goals[agent]), pathCost(node.paths[agent]),
+                collectConstraints(&node, agent, problem.options.reservations)));
+        }
+        return *mdd;
+    }
+
+    // Whether forbidding the conflict to 'agent' lengthens its path: all its
+    // equally cheap paths go through the conflicting cell (or move).
+    bool isCardinalFor(const CBSProblem& problem, CTNode& node, int agent, const Conflict& conflict) {
+        const MDD& mdd = nodeMDD(problem, node, agent);
+        if (mdd.empty()) return false;
+        auto single = [&](int t) {
+            return mdd.levels[std::min(t, mdd.cost)].size() == 1;
+            };
+        if (!conflict.isEdge) return single(conflict.timestep);
+        return single(conflict.timestep - 1) && single(conflict.timestep);
+    }
+
+    // The conflict to split on: cardinal before semi-cardinal before the rest,
+    // the earliest within a class.
+    const Conflict& selectCardinalConflict(const CBSProblem& problem, CTNode& node, ConflictClass& conflictClass) {
+        const Conflict* best = nullptr;
+        conflictClass = NON_CARDINAL;
+        for (const Conflict& conflict : node.conflicts) {
+            int cardinal = isCardinalFor(problem, node, conflict.agent1, conflict)
+                + isCardinalFor(problem, node, conflict.agent2, conflict);
+            ConflictClass candidate = static_cast<ConflictClass>(cardinal);
+            if (!best || candidate > conflictClass
+                || (candidate == conflictClass && conflictKey(conflict) < conflictKey(*best))) {
+                best = &conflict;
+                conflictClass = candidate;
+            }
+        }
+        return *best;
+    }
+
+    // Rectangle reasoning for a vertex conflict that both agents reach at the
+    // earliest possible time, i.e. on Manhattan-optimal paths from their starts.
+    // If one agent crosses the rectangle spanned by the two starts and the two
+    // points where their monotone moves end from side to side and the other from
+    // top to bottom, any such pair of crossings collides. Each child then forbids
+    // one agent to reach its far border at the earliest time (a barrier).
+    bool rectangleBranches(const CBSProblem& problem, const CTNode& node, const Conflict& conflict,
+        std::vector<Constraint> branches[2]) {
+
+        if (conflict.isEdge) return false;
+        const Position v = conflict.loc1;
+        const int t = conflict.timestep;
+        const int agents[2] = { conflict.agent1, conflict.agent2 };
+        Position s[2], g[2];
+        for (int i = 0; i < 2; ++i) {
+            s[i] = problem.starts[agents[i]];
+            if (manhattan(s[i], v) != t) return false;
+        }
+        if (sign(v.x - s[0].x) * sign(v.x - s[1].x) < 0 || sign(v.y - s[0].y) * sign(v.y - s[1].y) < 0) return false;
+        const int dx = sign(v.x - s[0].x) != 0 ? sign(v.x - s[0].x) : sign(v.x - s[1].x);
+        const int dy = sign(v.y - s[0].y) != 0 ? sign(v.y - s[0].y) : sign(v.y - s[1].y);
+        if (dx == 0 || dy == 0) return false;
+
+        // Follow each path on from the conflict while it keeps moving the same way
+        for (int i = 0; i < 2; ++i) {
+            const Path& path = node.paths[agents[i]];
+            size_t k = t;
+            while (k + 1 < path.size()) {
+                int stepX = path[k + 1].x - path[k].x;
+                int stepY = path[k + 1].y - path[k].y;
+                if (!(stepX == dx && stepY == 0) && !(stepX == 0 && stepY == dy)) break;
+                ++k;
+            }
+            g[i] = path[k];
+        }
+
+        // Corners nearest to the starts and to the ends
+        const Position rs = { dx > 0 ? std::max(s[0].x, s[1].x) : std::min(s[0].x, s[1].x),
+            dy > 0 ? std::max(s[0].y, s[1].y) : std::min(s[0].y, s[1].y) };
+        const Position rg = { dx > 0 ? std::min(g[0].x, g[1].x) : std::max(g[0].x, g[1].x),
+            dy > 0 ? std::min(g[0].y, g[1].y) : std::max(g[0].y, g[1].y) };
+        if ((rg.x - rs.x) * dx <= 0 || (rg.y - rs.y) * dy <= 0) return false;
+
+        // 'across' enters through the side where x starts and leaves through the
+        // opposite side; the other one crosses the rectangle from top to bottom
+        auto crossesInX = [&](int a, int b) {
+            return (s[b].x - s[a].x) * dx >= 0 && (s[a].y - s[b].y) * dy >= 0
+                && (g[a].x - g[b].x) * dx >= 0 && (g[b].y - g[a].y) * dy >= 0;
+            };
+        int across;
+        if (crossesInX(0, 1)) across = 0;
+        else if (crossesInX(1, 0)) across = 1;
+        else return false;
+        const int down = 1 - across;
+
+        for (int y = rs.y; y != rg.y + dy; y += dy) {
+            Position cell = { rg.x, y };
+            branches[across].push_back({ Constraint::VERTEX, agents[across], cell, cell, manhattan(s[across], cell) });
+        }
+        for (int x = rs.x; x != rg.x + dx; x += dx) {
+            Position cell = { x, rg.y };
+            branches[down].push_back({ Constraint::VERTEX, agents[down], cell, cell, manhattan(s[down], cell) });
+        }
+        return true;
+    }
+
+    // Length of the shortest path between two cells that does not enter the
+    // cells marked in 'avoid'; DistanceTable::UNREACHABLE if there is none.
+    int distanceAvoiding(const Grid& grid, int from, int to, const std::vector<char>& avoid) {
+        std::vector<int32_t> distances(grid.getCellCount(), -1);
+        std::vector<int> queue;
+        queue.push_back(from);
+        distances[from] = 0;
+        const int* offsets = grid.getNeighborOffsets();
+        for (size_t head = 0; head < queue.size(); ++head) {
+            int cell = queue[head];
+            if (cell == to) return distances[cell];
+            for (int dir = 0; dir < Grid::NUM_DIRECTIONS; ++dir) {
+                int next = cell + offsets[dir];
+                if (grid.isBlocked(next) || avoid[next] || distances[next] >= 0) continue;
+                distances[next] = distances[cell] + 1;
+                queue.push_back(next);
+            }
+        }
+        return DistanceTable::UNREACHABLE;
+    }
+
+    // Corridor reasoning for a conflict inside a chain of cells with two free
+    // neighbours each, where the agents move in opposite directions. One of them
+    // passes through first, so either the agent heading for the far end e2 stays
+    // out of e2 until the other one could have crossed the corridor, or the other
+    // stays out of e1 likewise. Arrival times are distance lower bounds, which
+    // only shortens the forbidden ranges.
+    bool corridorBranches(const CBSProblem& problem, const CTNode& node, const Conflict& conflict,
+        std::vector<Constraint> branches[2]) {
+
+        const Grid& grid = problem.grid;
+        const int* offsets = grid.getNeighborOffsets();
+        auto degree = [&](int cell) {
+            int count = 0;
+            for (int dir = 0; dir < Grid::NUM_DIRECTIONS; ++dir) {
+                if (!grid.isBlocked(cell + offsets[dir])) ++count;
+            }
+            return count;
+            };
+        const int conflictCell = grid.toId(conflict.loc1);
+        if (degree(conflictCell) != 2) return false;
+        if (conflict.isEdge && degree(grid.toId(conflict.loc2)) != 2) return false;
+
+        // Walk the chain both ways from the conflict
+        std::vector<int> sides[2];
+        int side = 0;
+        for (int dir = 0; dir < Grid::NUM_DIRECTIONS; ++dir) {
+            int previous = conflictCell;
+            int cell = conflictCell + offsets[dir];
+            if (grid.isBlocked(cell)) continue;
+            while (cell != conflictCell && degree(cell) == 2) {
+                sides[side].push_back(cell);
+                int next = -1;
+                for (int d = 0; d < Grid::NUM_DIRECTIONS && next < 0; ++d) {
+                    int neighbour = cell + offsets[d];
+                    if (neighbour != previous && !grid.isBlocked(neighbour)) next = neighbour;
+                }
+                previous = cell;
+                cell = next;
+            }
+            if (cell == conflictCell) return false;  // A ring has no ends
+            ++side;
+        }
+        std::vector<int> chain(sides[0].rbegin(), sides[0].rend());
+        chain.push_back(conflictCell);
+        chain.insert(chain.end(), sides[1].begin(), sides[1].end());
+        const int length = static_cast<int>(chain.size()) - 1;
+        if (length < 1) return false;
+
+        std::vector<char> inChain(grid.getCellCount(), 0);
+        for (int cell : chain) inChain[cell] = 1;
+        auto adjacent = [&](int a, int b) {
+            for (int dir = 0; dir < Grid::NUM_DIRECTIONS; ++dir) {
+                if (a + offsets[dir] == b) return true;
+            }
+            return false;
+            };
+        // Position along the chain; the cells just outside its ends are -1 and length + 1
+        auto indexOf = [&](const Position& p) {
+            const int cell = grid.toId(p);
+            if (inChain[cell]) return static_cast<int>(std::find(chain.begin(), chain.end(), cell) - chain.begin());
+            if (adjacent(cell, chain.front())) return -1;
+            if (adjacent(cell, chain.back())) return length + 1;
+            return -2;
+            };
+        auto direction = [&](int agent) {
+            const Path& path = node.paths[agent];
+            for (int t = std::max(1, conflict.timestep); t <= conflict.timestep + 1; ++t) {
+                int from = indexOf(positionAt(path, t - 1));
+                int to = indexOf(positionAt(path, t));
+                if (from != -2 && to != -2 && from != to) return sign(to - from);
+            }
+            return 0;
+            };
+
+        const int agents[2] = { conflict.agent1, conflict.agent2 };
+        const int dir0 = direction(agents[0]);
+        if (dir0 == 0 || direction(agents[1]) != -dir0) return false;
+        for (int agent : agents) {
+            if (inChain[grid.toId(problem.starts[agent])] || inChain[grid.toId(problem.goals[agent])]) return false;
+        }
+
+        // ends[i]: the end agents[i] heads for
+        const int forward = dir0 > 0 ? 0 : 1;
+        int ends[2];
+        ends[forward] = chain.back();
+        ends[1 - forward] = chain.front();
+
+        int earliest[2], bypassing[2];
+        for (int i = 0; i < 2; ++i) {
+            const int startCell = grid.toId(problem.starts[agents[i]]);
+            earliest[i] = problem.heuristics.get(ends[i])->at(startCell);
+            if (earliest[i] == DistanceTable::UNREACHABLE) return false;
+            inChain[ends[i]] = 0;
+            bypassing[i] = distanceAvoiding(grid, startCell, ends[i], inChain);
+            inChain[ends[i]] = 1;
+        }
+
+        for (int i = 0; i < 2; ++i) {
+            const int other = 1 - i;
+            const int last = std::min(bypassing[i] - 1, earliest[other] + length);
+            const Path& path = node.paths[agents[i]];
+            bool violated = false;
+            for (int t = 0; t <= last && t < static_cast<int>(path.size()) && !violated; ++t) {
+                violated = grid.toId(path[t]) == ends[i];
+            }
+            if (!violated) return false;  // The split would not move this agent
+            const Position end = grid.toPosition(ends[i]);
+            for (int t = 0; t <= last; ++t) {
+                branches[i].push_back({ Constraint::VERTEX, agents[i], end, end, t });
+            }
+        }
+        return true;
+    }
+
+    // Splits one conflict of the node: each child adds constraints for one of the
+    // two agents and replans that agent. Children without a path are dropped.
+    // Only the replanned agent is checked for new conflicts; the detector holds
+    // the node's paths and is restored before returning.
+    void expandNode(const CBSProblem& problem, CTNode& node, SearchWorkspace& workspace,
+        ConflictDetector& detector, SolverStats& stats, std::vector<std::unique_ptr<CTNode>>& children) {
+
+        const CBSOptions& options = problem.options;
+        detector.syncPaths(node.paths);
+        ConflictClass conflictClass = NON_CARDINAL;
+        const Conflict conflict = options.prioritizeConflicts
+            ? selectCardinalConflict(problem, node, conflictClass) : selectConflict(node.conflicts);
+        if (options.prioritizeConflicts) {
+            if (conflictClass == CARDINAL) stats.cardinalConflicts++;
+            else if (conflictClass == SEMI_CARDINAL) stats.semiCardinalConflicts++;
+            else stats.nonCardinalConflicts++;
+        }
+
+        std::vector<Constraint> branches[2];
+        if (options.rectangleReasoning && rectangleBranches(problem, node, conflict, branches)) {
+            stats.rectangleSplits++;
+        }
+        else if (options.corridorReasoning && corridorBranches(problem, node, conflict, branches)) {
+            stats.corridorSplits++;
+        }
+        else {
+            branches[0].clear();
+            branches[1].clear();
+            if (conflict.isEdge) {
+                branches[0].push_back({ Constraint::EDGE, conflict.agent1, conflict.loc1, conflict.loc2, conflict.timestep });
+                branches[1].push_back({ Constraint::EDGE, conflict.agent2, conflict.loc2, conflict.loc1, conflict.timestep });
+            }
+            else {
+                branches[0].push_back({ Constraint::VERTEX, conflict.agent1, conflict.loc1, conflict.loc1, conflict.timestep });
+                branches[1].push_back({ Constraint::VERTEX, conflict.agent2, conflict.loc1, conflict.loc1, conflict.timestep });
+            }
+        }
+
+        for (std::vector<Constraint>& constraints : branches) {
+            const int agent = constraints.front().agent;
+            std::unique_ptr<CTNode> child(new CTNode());
+            child->parent = &node;
+            child->constraints = std::move(constraints);
+
+            ConstraintTable table = collectConstraints(child.get(), agent, problem.options.reservations);
+            Path newPath = findPathWithConstraints(problem.starts[agent], problem.goals[agent], problem.grid,
+                table, workspace, problem.heuristics.get(problem.goals[agent]).get(), &stats.lowLevelExpanded);
+            stats.lowLevelCalls++;
+            if (newPath.empty()) continue;
+
+            for (const Conflict& inherited : node.conflicts) {
+                if (inherited.agent1 != agent && inherited.agent2 != agent) child->conflicts.push_back(inherited);
+            }
+            detector.setPath(agent, newPath);
+            detector.findConflicts(agent, child->conflicts);
+            detector.setPath(agent, node.paths[agent]);
+
+            child->paths = node.paths;
+            child->paths[agent] = std::move(newPath);
+            child->mdds = node.mdds;
+            child->mdds[agent].reset();
+            child->cost = sumOfCosts(child->paths);
+            child->numConflicts = static_cast<int>(child->conflicts.size());
+            children.push_back(std::move(child));
+        }
+    }
+
+    // Bypass: a child as cheap as the node but with fewer conflicts is not
+    // added; its new path replaces the one in the node, which goes back to the
+    // open list. The node's MDDs stay valid, as the cost is unchanged.
+    bool adoptBypass(CTNode& node, std::vector<std::unique_ptr<CTNode>>& children) {
+        CTNode* best = nullptr;
+        for (auto& child : children) {
+            if (child->cost == node.cost && child->numConflicts < (best ? best->numConflicts : node.numConflicts)) {
+                best = child.get();
+            }
+        }
+        if (!best) return false;
+        const int agent = best->constraints.front().agent;
+        node.paths[agent] = std::move(best->paths[agent]);
+        node.conflicts = std::move(best->conflicts);
+        node.numConflicts = best->numConflicts;
+        return true;
+    }
+
+    void releaseNode(CTNode& node) {
+        std::vector<Path>().swap(node.paths);
+        std::vector<Conflict>().swap(node.conflicts);
+        std::vector<std::shared_ptr<const MDD>>().swap(node.mdds);
+    }
+
+    bool limitReached(const CBSOptions& options, int expanded, Clock::time_point startTime) {
+        return expanded >= options.maxNodes || secondsSince(startTime) > options.timeLimitSeconds
+            || isCancelled(options.control);
+    }
+
+    // Classic single-threaded best-first CT search. Returns the goal node or nullptr.
+    const CTNode* searchSerial(const CBSProblem& problem, const CBSOptions& options, Clock::time_point startTime,
+        std::deque<std::unique_ptr<CTNode>>& storage, SolverStats& stats) {
+
+        SearchWorkspace workspace;
+        ConflictDetector detector(problem.grid);
+        CTOpenList openList;
+        openList.push(storage.front().get());
+        std::vector<std::unique_ptr<CTNode>> children;
+        auto workerStart = Clock::now();
+
+        const CTNode* goal = nullptr;
+        while (!openList.empty() && !limitReached(options, stats.highLevelExpanded, startTime)) {
+            CTNode* current = openList.top();
+            openList.pop();
+
+            if (current->numConflicts == 0) {
+                goal = current;
+                break;
+            }
+            stats.highLevelExpanded++;
+            PROFILE_COUNT(CT_NODES_EXPANDED, 1);
+            publishProgress(options.control, stats.highLevelExpanded, current->cost, current->numConflicts);
+
+            children.clear();
+            expandNode(problem, *current, workspace, detector, stats, children);
+            if (options.bypass && adoptBypass(*current, children)) {
+                stats.bypasses++;
+                openList.push(current);
+                continue;
+            }
+            for (auto& child : children) {
+                child->id = static_cast<int>(storage.size());
+                openList.push(child.get());
+                storage.push_back(std::move(child));
+                stats.highLevelGenerated++;
+                PROFILE_COUNT(CT_NODES_GENERATED, 1);
+            }
+
+            // Expanded nodes only need their constraints and parent link from now on.
+            releaseNode(*current);
+        }
+
+        stats.workerSeconds = secondsSince(workerStart);
+        return goal;
+    }
+
+    // Parallel best-first CT search. Workers share one open list and expand nodes
+    // concurrently, each with its own low-level workspace. A conflict-free node
+    // becomes the incumbent; the search ends once no open or in-flight node is
+    // cheaper than it, so the returned cost is the optimal one, as in the serial
+    // search. An incumbent that is not proven optimal when a limit is reached is
+    // dropped, so the search returns nullptr like the serial one. Expansion
+    // counts may differ slightly with the interleaving.
+    const CTNode* searchParallel(const CBSProblem& problem, const CBSOptions& options, Clock::time_point startTime,
+        std::deque<std::unique_ptr<CTNode>>& storage, SolverStats& stats) {
+
+        std::mutex mutex;
+        std::condition_variable wakeUp;
+        CTOpenList openList;
+        openList.push(storage.front().get());
+        const CTNode* incumbent = nullptr;
+        int inFlight = 0;
+        bool stop = false;
+        std::vector<SolverStats> workerStats(options.numThreads);
+
+        // Called with the mutex held.
+        auto hasUsefulWork = [&]() {
+            return !openList.empty() && (!incumbent || openList.top()->cost < incumbent->cost);
+            };
+
+        auto worker = [&](int workerIndex) {
+            PROFILE_PHASE(HIGH_LEVEL);
+            SearchWorkspace workspace;
+            ConflictDetector detector(problem.grid);
+            SolverStats& local = workerStats[workerIndex];
+            std::vector<std::unique_ptr<CTNode>> children;
+            auto workerStart = Clock::now();
+            double idleSeconds = 0.0;
+
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                auto waitStart = Clock::now();
+                wakeUp.wait(lock, [&]() { return stop || hasUsefulWork() || inFlight == 0; });
+                idleSeconds += secondsSince(waitStart);
+                if (stop) break;
+
+                bool outOfBudget = limitReached(options, stats.highLevelExpanded, startTime);
+                if (outOfBudget || !hasUsefulWork()) {
+                    if (outOfBudget || inFlight == 0) {
+                        // Nothing cheaper than the incumbent can appear any more, or
+                        // the budget is spent; in-flight nodes still finish below
+                        stop = true;
+                        wakeUp.notify_all();
+                        break;
+                    }
+                    continue;
+                }
+
+                CTNode* current = openList.top();
+                openList.pop();
+                if (current->numConflicts == 0) {
+                    if (!incumbent || CTNodeCompare()(incumbent, current)) {
+                        incumbent = current;
+                    }
+                    wakeUp.notify_all();
+                    continue;
+                }
+
+                stats.highLevelExpanded++;
+                PROFILE_COUNT(CT_NODES_EXPANDED, 1);
+                publishProgress(options.control, stats.highLevelExpanded, current->cost, current->numConflicts);
+                ++inFlight;
+                lock.unlock();
+
+                children.clear();
+                expandNode(problem, *current, workspace, detector, local, children);
+                const bool bypassed = options.bypass && adoptBypass(*current, children);
+                if (!bypassed) releaseNode(*current);
+
+                lock.lock();
+                --inFlight;
+                if (bypassed) {
+                    stats.bypasses++;
+                    openList.push(current);
+                }
+                else {
+                    for (auto& child : children) {
+                        child->id = static_cast<int>(storage.size());
+                        openList.push(child.get());
+                        storage.push_back(std::move(child));
+                        stats.highLevelGenerated++;
+                        PROFILE_COUNT(CT_NODES_GENERATED, 1);
+                    }
+                }
+                wakeUp.notify_all();
+            }
+            local.workerSeconds = secondsSince(workerStart) - idleSeconds;
+            };
+
+        // Workers count into the profile of the calling thread
+        SearchProfile* profile = currentProfile();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < options.numThreads; ++i) {
+            threads.emplace_back([&worker, profile, i]() {
+                ProfileScope scope(profile);
+                worker(i);
+                });
+        }
+        for (auto& thread : threads) thread.join();
+
+        // All in-flight children are in the open list now. Stopped by a limit
+        // while a cheaper node was still open, the incumbent is not proven optimal.
+        if (incumbent && !openList.empty() && openList.top()->cost < incumbent->cost) {
+            incumbent = nullptr;
+        }
+
+        for (const auto& local : workerStats) {
+            stats.lowLevelExpanded += local.lowLevelExpanded;
+            stats.lowLevelCalls += local.lowLevelCalls;
+            stats.workerSeconds += local.workerSeconds;
+            stats.cardinalConflicts += local.cardinalConflicts;
+            stats.semiCardinalConflicts += local.semiCardinalConflicts;
+            stats.nonCardinalConflicts += local.nonCardinalConflicts;
+            stats.rectangleSplits += local.rectangleSplits;
+            stats.corridorSplits += local.corridorSplits;
+        }
+        return incumbent;
+    }
+}
+
+SolverResult solveCBS(const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid, const CBSOptions& options) {
+
+    PROFILE_PHASE(HIGH_LEVEL);
+    auto startTime = Clock::now();
+    SolverResult result;
+    result.stats.threads = std::max(1, options.numThreads);
+    const int numAgents = static_cast<int>(starts.size());
+
+    std::unique_ptr<HeuristicCache> privateCache;
+    HeuristicCache* heuristics = options.heuristics;
+    if (!heuristics) {
+        privateCache.reset(new HeuristicCache(grid));
+        heuristics = privateCache.get();
+    }
+    CBSProblem problem = { starts, goals, grid, *heuristics, options };
+
+    std::deque<std::unique_ptr<CTNode>> storage;
+    storage.emplace_back(new CTNode());
+    CTNode& root = *storage.back();
+    root.parent = nullptr;
+    root.id = 0;
+    root.paths.resize(numAgents);
+    root.mdds.resize(numAgents);
+
+    SearchWorkspace workspace;
+    ConstraintTable rootConstraints;
+    rootConstraints.setReservations(options.reservations);
+    for (int i = 0; i < numAgents; ++i) {
+        root.paths[i] = findPathWithConstraints(starts[i], goals[i], grid, rootConstraints, workspace,
+            heuristics->get(goals[i]).get(), &result.stats.lowLevelExpanded);
+        result.stats.lowLevelCalls++;
+        if (root.paths[i].empty() || isCancelled(options.control)) {
+            result.stats.runtimeSeconds = secondsSince(startTime);
+            return result;  // Some agent cannot reach its goal at all, or the caller gave up
+        }
+    }
+
+    ConflictDetector detector(grid);
+    detector.syncPaths(root.paths);
+    detector.findAllConflicts(root.conflicts);
+    root.cost = sumOfCosts(root.paths);
+    root.numConflicts = static_cast<int>(root.conflicts.size());
+    result.stats.highLevelGenerated = 1;
+    PROFILE_COUNT(CT_NODES_GENERATED, 1);
+
+    const CTNode* goal = options.numThreads > 1
+        ? searchParallel(problem, options, startTime, storage, result.stats)
+        : searchSerial(problem, options, startTime, storage, result.stats);
+
+    if (goal) {
+        result.solved = true;
+        result.paths = goal->paths;
+        result.sumOfCosts = sumOfCosts(result.paths);
+        result.lowerBound = result.sumOfCosts;
+        for (const auto& path : result.paths) {
+            result.makespan = std::max(result.makespan, pathCost(path));
+        }
+    }
+    result.stats.runtimeSeconds = secondsSince(startTime);
+    return result;
+}
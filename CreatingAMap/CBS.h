@@ -0,0 +1,39 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "HeuristicCache.h"
+#include "SearchControl.h"
+#include "ReservationTable.h"
+
+struct CBSOptions {
+    int maxNodes = 100000;          // CT node expansion limit
+    double timeLimitSeconds = 60.0;
+    HeuristicCache* heuristics = nullptr;  // Shared distance tables; a private cache is used if null
+    int numThreads = 1;                    // Above 1, CT nodes are expanded by a pool of workers
+    SearchControl* control = nullptr;      // Progress and cancellation, optional
+    const ReservationTable* reservations = nullptr;  // Paths of agents outside the problem to avoid, optional
+
+    // Improvements over plain CBS; none of them affects the solution cost
+    bool prioritizeConflicts = true;  // Split cardinal, then semi-cardinal conflicts first (MDD-based)
+    bool bypass = true;               // Adopt an equally cheap child with fewer conflicts instead of branching
+    bool rectangleReasoning = false;  // Barrier constraints for rectangle conflicts (see README)
+    bool corridorReasoning = true;    // Range constraints for conflicts inside corridors
+};
+
+// Conflict-Based Search (Sharon et al. 2015). The high level is a best-first
+// search over the constraint tree ordered by sum-of-costs; the low level is a
+// space-time A* that honours the vertex and edge constraints of each agent.
+// With several threads the workers share the open list and each runs its own
+// low-level workspace; the solution cost stays optimal.
+//
+// Conflicts are classified with the agents' MDDs: cardinal if forbidding it to
+// either agent makes that agent's path longer, semi-cardinal if only for one of
+// them. Splitting cardinal conflicts first raises the lower bound soonest
+// (Boyarski et al. 2015), as does the bypass that resolves non-cardinal
+// conflicts without branching. Rectangle reasoning (Li et al. 2019) and
+// corridor reasoning (Li et al. 2020) replace the single vertex constraint of a
+// symmetric conflict by a set of constraints, so that one split settles what
+// would otherwise take exponentially many.
+SolverResult solveCBS(const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid, const CBSOptions& options = CBSOptions());
@@ -0,0 +1,71 @@
+#include "CompactPath.h"
+
+namespace {
+    const int DX[] = { 1, 0, -1, 0, 0 };
+    const int DY[] = { 0, 1, 0, -1, 0 };
+
+    int moveBetween(const Position& from, const Position& to) {
+        for (int move = CompactPath::RIGHT; move <= CompactPath::WAIT; ++move) {
+            if (from.x + DX[move] == to.x && from.y + DY[move] == to.y) return move;
+        }
+        return -1;
+    }
+
+    int runMove(uint8_t code) { return code & 7; }
+    int runLength(uint8_t code) { return (code >> 3) + 1; }
+}
+
+bool CompactPath::encode(const Path& path) {
+    codes.clear();
+    length = 0;
+    if (path.empty()) return true;
+
+    for (size_t t = 1; t < path.size(); ++t) {
+        const int move = moveBetween(path[t - 1], path[t]);
+        if (move < 0) {
+            codes.clear();
+            return false;
+        }
+        // Extend the last run while it has room
+        if (!codes.empty() && runMove(codes.back()) == move && runLength(codes.back()) < MAX_RUN) {
+            codes.back() += 8;
+        }
+        else {
+            codes.push_back(static_cast<uint8_t>(move));
+        }
+    }
+    start = path[0];
+    length = static_cast<int>(path.size());
+    return true;
+}
+
+Path CompactPath::decode() const {
+    Path path;
+    if (length == 0) return path;
+    path.reserve(length);
+    Position position = start;
+    path.push_back(position);
+    for (uint8_t code : codes) {
+        const int move = runMove(code);
+        for (int i = runLength(code); i > 0; --i) {
+            position.x += DX[move];
+            position.y += DY[move];
+            path.push_back(position);
+        }
+    }
+    return path;
+}
+
+bool CompactPath::assign(const Position& start, int length, const uint8_t* codes, size_t count) {
+    long long steps = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (runMove(codes[i]) > WAIT) return false;
+        steps += runLength(codes[i]);
+    }
+    if (length < 0 || (length == 0 ? count != 0 : steps != length - 1)) return false;
+
+    this->start = start;
+    this->length = length;
+    this->codes.assign(codes, codes + count);
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// A path stored as its start cell and run-length coded moves, for archiving
+// and replaying solutions. Every byte is one run: the move in the low 3 bits
+// (right, down, left, up as in Grid's neighbour order, or wait) and the run
+// length minus one in the high 5 bits, so up to 32 equal steps share a byte.
+// A straight corridor that takes 256 bytes as a Path takes one byte here.
+class CompactPath {
+public:
+    enum Move { RIGHT, DOWN, LEFT, UP, WAIT };
+    static constexpr int MAX_RUN = 32;
+
+    // Fails and leaves the path empty if two consecutive cells are neither
+    // equal nor neighbours.
+    bool encode(const Path& path);
+    Path decode() const;
+
+    // Takes stored codes; fails if their steps do not add up to 'length'.
+    bool assign(const Position& start, int length, const uint8_t* codes, size_t count);
+
+    bool empty() const { return length == 0; }
+    // Cells of the decoded path, as Path::size()
+    int getLength() const { return length; }
+    Position getStart() const { return start; }
+    const std::vector<uint8_t>& getCodes() const { return codes; }
+
+private:
+    Position start = { 0, 0 };
+    int length = 0;
+    std::vector<uint8_t> codes;
+};
@@ -0,0 +1,187 @@
+#include "ConflictDetector.h"
+#include "Profiling.h"
+#include <algorithm>
+
+#ifdef MAPF_PROFILE
+namespace {
+    // Counts the conflicts appended to 'out' from index 'first' on by type
+    void countConflicts(const std::vector<Conflict>& out, size_t first) {
+        long long edges = 0;
+        for (size_t i = first; i < out.size(); ++i) {
+            if (out[i].isEdge) edges++;
+        }
+        profileCount(EDGE_CONFLICTS, edges);
+        profileCount(VERTEX_CONFLICTS, static_cast<long long>(out.size() - first) - edges);
+    }
+}
+#endif
+
+ConflictDetector::ConflictDetector(const Grid& grid)
+    : grid(grid), visits(grid.getCellCount()) {}
+
+void ConflictDetector::reset(int numAgents) {
+    for (auto& path : cellPaths) {
+        for (int cell : path) visits[cell].clear();
+    }
+    cellPaths.assign(numAgents, std::vector<int>());
+}
+
+void ConflictDetector::clearPath(int agent) {
+    for (int cell : cellPaths[agent]) {
+        auto& list = visits[cell];
+        for (size_t i = 0; i < list.size();) {
+            if (list[i].agent == agent) {
+                list[i] = list.back();
+                list.pop_back();
+            }
+            else {
+                ++i;
+            }
+        }
+    }
+    cellPaths[agent].clear();
+}
+
+void ConflictDetector::setPath(int agent, const Path& path) {
+    clearPath(agent);
+    std::vector<int>& cells = cellPaths[agent];
+    cells.reserve(path.size());
+    for (size_t t = 0; t < path.size(); ++t) {
+        int cell = grid.toId(path[t]);
+        cells.push_back(cell);
+        visits[cell].push_back({ agent, static_cast<int>(t) });
+    }
+}
+
+bool ConflictDetector::samePath(int agent, const Path& path) const {
+    const std::vector<int>& cells = cellPaths[agent];
+    if (cells.size() != path.size()) return false;
+    for (size_t t = 0; t < path.size(); ++t) {
+        if (cells[t] != grid.toId(path[t])) return false;
+    }
+    return true;
+}
+
+void ConflictDetector::syncPaths(const std::vector<Path>& paths) {
+    if (cellPaths.size() != paths.size()) reset(static_cast<int>(paths.size()));
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!samePath(static_cast<int>(i), paths[i])) setPath(static_cast<int>(i), paths[i]);
+    }
+}
+
+void ConflictDetector::scanAgent(int agent, bool skipLowerAgents, bool firstOnly,
+    std::vector<Conflict>& out) const {
+
+    const std::vector<int>& cells = cellPaths[agent];
+    if (cells.empty()) return;
+    const int lastTime = static_cast<int>(cells.size()) - 1;
+
+    auto report = [&](int other, int timestep, int cell, int otherCell, bool isEdge) {
+        out.push_back({ agent, other, grid.toPosition(cell), grid.toPosition(otherCell), timestep, isEdge });
+        };
+    auto skip = [&](int other) {
+        return other == agent || (skipLowerAgents && other < agent);
+        };
+
+    for (int t = 0; t <= lastTime; ++t) {
+        const int cell = cells[t];
+        for (const Visit& visit : visits[cell]) {
+            if (skip(visit.agent)) continue;
+            int otherLast = static_cast<int>(cellPaths[visit.agent].size()) - 1;
+
+            // Same cell at the same time, or the other agent is already parked here
+            if (visit.timestep == t || (visit.timestep == otherLast && otherLast < t)) {
+                report(visit.agent, t, cell, cell, false);
+                if (firstOnly) return;
+            }
+        }
+
+        if (t == 0 || cells[t - 1] == cell) continue;
+
+        // Swap: someone moves from 'cell' into our previous cell during the same step
+        const int previous = cells[t - 1];
+        for (const Visit& visit : visits[previous]) {
+            if (visit.timestep != t || skip(visit.agent)) continue;
+            if (cellPaths[visit.agent][t - 1] == cell) {
+                report(visit.agent, t, previous, cell, true);
+                if (firstOnly) return;
+            }
+        }
+    }
+
+    // After its path ends the agent stays at its goal; anyone passing later collides
+    const int goal = cells[lastTime];
+    for (const Visit& visit : visits[goal]) {
+        if (skip(visit.agent) || visit.timestep <= lastTime) continue;
+        report(visit.agent, visit.timestep, goal, goal, false);
+        if (firstOnly) return;
+    }
+}
+
+void ConflictDetector::findConflicts(int agent, std::vector<Conflict>& out) const {
+    PROFILE_PHASE(CONFLICT_DETECTION);
+    PROFILE_ONLY(const size_t first = out.size();)
+    scanAgent(agent, false, false, out);
+    PROFILE_ONLY(countConflicts(out, first);)
+}
+
+void ConflictDetector::findAllConflicts(std::vector<Conflict>& out) const {
+    PROFILE_PHASE(CONFLICT_DETECTION);
+    PROFILE_ONLY(const size_t first = out.size();)
+    for (int agent = 0; agent < getNumAgents(); ++agent) {
+        scanAgent(agent, true, false, out);
+    }
+    PROFILE_ONLY(countConflicts(out, first);)
+}
+
+bool ConflictDetector::hasConflicts() const {
+    PROFILE_PHASE(CONFLICT_DETECTION);
+    std::vector<Conflict> found;
+    for (int agent = 0; agent < getNumAgents() && found.empty(); ++agent) {
+        scanAgent(agent, true, true, found);
+    }
+    return !found.empty();
+}
+
+int ConflictDetector::countMoveConflicts(int agent, int fromCell, int toCell, int timestep) const {
+    int count = 0;
+    for (const Visit& visit : visits[toCell]) {
+        if (visit.agent == agent) continue;
+        const std::vector<int>& other = cellPaths[visit.agent];
+        int otherLast = static_cast<int>(other.size()) - 1;
+        if (visit.timestep == timestep || (visit.timestep == otherLast && otherLast < timestep)) {
+            ++count;
+        }
+        else if (fromCell != toCell && visit.timestep == timestep - 1
+            && timestep <= otherLast && other[timestep] == fromCell) {
+            ++count;  // The other agent moves the opposite way
+        }
+    }
+    return count;
+}
+
+int ConflictDetector::getLastTimestep() const {
+    int last = 0;
+    for (const auto& cells : cellPaths) last = std::max(last, static_cast<int>(cells.size()) - 1);
+    return last;
+}
+
+int ConflictDetector::agentAt(int cell, int timestep) const {
+    for (const Visit& visit : visits[cell]) {
+        int otherLast = static_cast<int>(cellPaths[visit.agent].size()) - 1;
+        if (visit.timestep == timestep || (visit.timestep == otherLast && otherLast < timestep)) {
+            return visit.agent;
+        }
+    }
+    return -1;
+}
+
+void ConflictDetector::collectVisitors(int cell, std::vector<int>& out) const {
+    for (const Visit& visit : visits[cell]) out.push_back(visit.agent);
+}
+
+bool hasConflictsInPaths(const std::vector<Path>& paths, const Grid& grid) {
+    ConflictDetector detector(grid);
+    detector.syncPaths(paths);
+    return detector.hasConflicts();
+}
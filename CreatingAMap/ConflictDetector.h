@@ -0,0 +1,71 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include <vector>
+
+struct Conflict {
+    int agent1, agent2;
+    Position loc1, loc2;  // loc2 is only used by edge conflicts
+    int timestep;
+    bool isEdge;          // Edge: agent1 moves loc1 -> loc2 while agent2 moves loc2 -> loc1
+};
+
+// Space-time occupancy of a set of paths. Every cell keeps the list of
+// (agent, timestep) visits that fall on it, so finding the conflicts of one
+// agent only looks at the cells of its own path, and replacing one agent's path
+// touches only that path. All conflicts of N paths are found in roughly
+// O(sum of path lengths) instead of O(makespan x N^2). Agents stay at their
+// goal after their path ends, which also counts as occupying it.
+class ConflictDetector {
+public:
+    explicit ConflictDetector(const Grid& grid);
+
+    void reset(int numAgents);
+
+    // Replaces the stored path of one agent (incremental update).
+    void setPath(int agent, const Path& path);
+    void clearPath(int agent);
+    // Updates only the agents whose path differs from the stored one.
+    void syncPaths(const std::vector<Path>& paths);
+
+    int getNumAgents() const { return static_cast<int>(cellPaths.size()); }
+
+    // Appends every conflict between 'agent' and any other agent. 'agent' is
+    // always reported as agent1.
+    void findConflicts(int agent, std::vector<Conflict>& out) const;
+    // Appends every conflict of the stored paths once.
+    void findAllConflicts(std::vector<Conflict>& out) const;
+    bool hasConflicts() const;
+
+    // Number of other agents that 'agent' would collide with by moving from
+    // 'fromCell' to 'toCell' and arriving at 'timestep' (vertex and swap
+    // conflicts, agents parked at their goal included). Used as the focal
+    // heuristic of bounded-suboptimal searches; the path stored for 'agent'
+    // itself is ignored.
+    int countMoveConflicts(int agent, int fromCell, int toCell, int timestep) const;
+    // Last timestep of the longest stored path; after it nobody moves.
+    int getLastTimestep() const;
+
+    // An agent at 'cell' at 'timestep', parked agents included; -1 if none.
+    int agentAt(int cell, int timestep) const;
+    // Appends every agent whose path passes through 'cell' (duplicates possible).
+    void collectVisitors(int cell, std::vector<int>& out) const;
+
+private:
+    struct Visit {
+        int agent;
+        int timestep;
+    };
+
+    // Visits 'agent' conflicts with; stops early when 'firstOnly' is set.
+    void scanAgent(int agent, bool skipLowerAgents, bool firstOnly, std::vector<Conflict>& out) const;
+    bool samePath(int agent, const Path& path) const;
+
+    const Grid& grid;
+    std::vector<std::vector<int>> cellPaths;  // Per agent, the cell id at every timestep
+    std::vector<std::vector<Visit>> visits;   // Per cell id, the agents passing through it
+};
+
+// One-shot check used where no detector is kept around.
+bool hasConflictsInPaths(const std::vector<Path>& paths, const Grid& grid);
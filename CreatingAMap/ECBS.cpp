@@ -0,0 +1,237 @@
+#include "ECBS.h"
+#include "LowLevel.h"
+#include "ConflictDetector.h"
+#include "Profiling.h"
+#include <queue>
+#include <set>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <tuple>
+
+namespace {
+    struct ECBSNode {
+        const ECBSNode* parent;  // nullptr for the root
+        Constraint constraint;   // Constraint added when this node was generated
+        std::vector<Path> paths;
+        std::vector<int> lowerBounds;  // Per agent, a lower bound on its cost under the constraints
+        std::vector<Conflict> conflicts;
+        int cost;
+        int lowerBound;          // Sum of 'lowerBounds'
+        int numConflicts;
+        int id;
+        bool open;
+    };
+
+    // OPEN is ordered by lower bound; its minimum is the LB of the whole search
+    struct ByLowerBound {
+        bool operator()(const ECBSNode* a, const ECBSNode* b) const {
+            if (a->lowerBound != b->lowerBound) return a->lowerBound < b->lowerBound;
+            return a->id < b->id;
+        }
+    };
+
+    // FOCAL prefers few conflicts, then low cost
+    struct ByConflicts {
+        bool operator()(const ECBSNode* a, const ECBSNode* b) const {
+            if (a->numConflicts != b->numConflicts) return a->numConflicts > b->numConflicts;
+            if (a->cost != b->cost) return a->cost > b->cost;
+            return a->id > b->id;
+        }
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    int sumOfCosts(const std::vector<Path>& paths) {
+        int total = 0;
+        for (const auto& path : paths) total += pathCost(path);
+        return total;
+    }
+
+    // The earliest conflict, ties broken by agent ids, as in CBS.
+    const Conflict& selectConflict(const std::vector<Conflict>& conflicts) {
+        auto key = [](const Conflict& c) {
+            return std::make_tuple(c.timestep, std::min(c.agent1, c.agent2), std::max(c.agent1, c.agent2));
+            };
+        const Conflict* best = &conflicts.front();
+        for (const Conflict& conflict : conflicts) {
+            if (key(conflict) < key(*best)) best = &conflict;
+        }
+        return *best;
+    }
+
+    ConstraintTable collectConstraints(const ECBSNode* node, int agent) {
+        ConstraintTable table;
+        for (; node->parent != nullptr; node = node->parent) {
+            if (node->constraint.agent == agent) {
+                table.add(node->constraint);
+            }
+        }
+        return table;
+    }
+
+    bool withinBound(int cost, int lowerBound, double suboptimality) {
+        return cost <= suboptimality * lowerBound + 1e-9;
+    }
+}
+
+SolverResult solveECBS(const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid, const ECBSOptions& options) {
+
+    PROFILE_PHASE(HIGH_LEVEL);
+    auto startTime = Clock::now();
+    SolverResult result;
+    const int numAgents = static_cast<int>(starts.size());
+    const double w = std::max(1.0, options.suboptimality);
+
+    std::unique_ptr<HeuristicCache> privateCache;
+    HeuristicCache* heuristics = options.heuristics;
+    if (!heuristics) {
+        privateCache.reset(new HeuristicCache(grid));
+        heuristics = privateCache.get();
+    }
+
+    SearchWorkspace workspace;
+    ConflictDetector detector(grid);
+    detector.reset(numAgents);
+
+    // The root plans the agents one after another, each avoiding the paths
+    // planned before it
+    std::deque<std::unique_ptr<ECBSNode>> storage;
+    storage.emplace_back(new ECBSNode());
+    ECBSNode& root = *storage.back();
+    root.parent = nullptr;
+    root.id = 0;
+    root.paths.resize(numAgents);
+    root.lowerBounds.resize(numAgents);
+    ConstraintTable noConstraints;
+    for (int i = 0; i < numAgents; ++i) {
+        root.paths[i] = findPathWithFocal(starts[i], goals[i], i, grid, noConstraints, detector, w, workspace,
+            heuristics->get(goals[i]).get(), &root.lowerBounds[i], &result.stats.lowLevelExpanded);
+        result.stats.lowLevelCalls++;
+        if (root.paths[i].empty() || isCancelled(options.control)) {
+            result.stats.runtimeSeconds = secondsSince(startTime);
+            return result;  // Some agent cannot reach its goal at all, or the caller gave up
+        }
+        detector.setPath(i, root.paths[i]);
+    }
+    detector.findAllConflicts(root.conflicts);
+    root.cost = sumOfCosts(root.paths);
+    root.lowerBound = 0;
+    for (int bound : root.lowerBounds) root.lowerBound += bound;
+    root.numConflicts = static_cast<int>(root.conflicts.size());
+    root.open = true;
+    result.stats.highLevelGenerated = 1;
+    PROFILE_COUNT(CT_NODES_GENERATED, 1);
+
+    std::set<ECBSNode*, ByLowerBound> openList;
+    std::priority_queue<ECBSNode*, std::vector<ECBSNode*>, ByConflicts> focalList;
+    openList.insert(&root);
+    focalList.push(&root);
+    int minLowerBound = root.lowerBound;
+
+    const ECBSNode* goal = nullptr;
+    int goalLowerBound = 0;
+    while (!openList.empty() && result.stats.highLevelExpanded < options.maxNodes
+        && secondsSince(startTime) <= options.timeLimitSeconds && !isCancelled(options.control)) {
+
+        // A higher LB admits the open nodes whose cost is now within the bound
+        const int openLowerBound = (*openList.begin())->lowerBound;
+        if (openLowerBound > minLowerBound) {
+            for (ECBSNode* node : openList) {
+                if (!withinBound(node->cost, minLowerBound, w) && withinBound(node->cost, openLowerBound, w)) {
+                    focalList.push(node);
+                }
+            }
+            minLowerBound = openLowerBound;
+        }
+
+        ECBSNode* current = focalList.top();
+        focalList.pop();
+        if (!current->open) continue;
+        current->open = false;
+        openList.erase(current);
+
+        if (current->numConflicts == 0) {
+            goal = current;
+            goalLowerBound = minLowerBound;
+            break;
+        }
+        result.stats.highLevelExpanded++;
+        PROFILE_COUNT(CT_NODES_EXPANDED, 1);
+        publishProgress(options.control, result.stats.highLevelExpanded, minLowerBound, current->numConflicts);
+
+        detector.syncPaths(current->paths);
+        const Conflict conflict = selectConflict(current->conflicts);
+        Constraint branches[2];
+        if (conflict.isEdge) {
+            branches[0] = { Constraint::EDGE, conflict.agent1, conflict.loc1, conflict.loc2, conflict.timestep };
+            branches[1] = { Constraint::EDGE, conflict.agent2, conflict.loc2, conflict.loc1, conflict.timestep };
+        }
+        else {
+            branches[0] = { Constraint::VERTEX, conflict.agent1, conflict.loc1, conflict.loc1, conflict.timestep };
+            branches[1] = { Constraint::VERTEX, conflict.agent2, conflict.loc1, conflict.loc1, conflict.timestep };
+        }
+
+        for (const Constraint& constraint : branches) {
+            const int agent = constraint.agent;
+            std::unique_ptr<ECBSNode> child(new ECBSNode());
+            child->parent = current;
+            child->constraint = constraint;
+
+            ConstraintTable table = collectConstraints(child.get(), agent);
+            int agentLowerBound = 0;
+            Path newPath = findPathWithFocal(starts[agent], goals[agent], agent, grid, table, detector, w, workspace,
+                heuristics->get(goals[agent]).get(), &agentLowerBound, &result.stats.lowLevelExpanded);
+            result.stats.lowLevelCalls++;
+            if (newPath.empty()) continue;
+
+            for (const Conflict& inherited : current->conflicts) {
+                if (inherited.agent1 != agent && inherited.agent2 != agent) child->conflicts.push_back(inherited);
+            }
+            detector.setPath(agent, newPath);
+            detector.findConflicts(agent, child->conflicts);
+            detector.setPath(agent, current->paths[agent]);
+
+            // Constraints only add up along a branch, so the bound never decreases
+            child->lowerBounds = current->lowerBounds;
+            child->lowerBounds[agent] = std::max(current->lowerBounds[agent], agentLowerBound);
+            child->lowerBound = current->lowerBound - current->lowerBounds[agent] + child->lowerBounds[agent];
+            child->paths = current->paths;
+            child->paths[agent] = std::move(newPath);
+            child->cost = sumOfCosts(child->paths);
+            child->numConflicts = static_cast<int>(child->conflicts.size());
+            child->id = static_cast<int>(storage.size());
+            child->open = true;
+
+            openList.insert(child.get());
+            if (withinBound(child->cost, minLowerBound, w)) focalList.push(child.get());
+            storage.push_back(std::move(child));
+            result.stats.highLevelGenerated++;
+            PROFILE_COUNT(CT_NODES_GENERATED, 1);
+        }
+
+        // Expanded nodes only need their constraint and parent link from now on
+        std::vector<Path>().swap(current->paths);
+        std::vector<int>().swap(current->lowerBounds);
+        std::vector<Conflict>().swap(current->conflicts);
+    }
+
+    if (goal) {
+        result.solved = true;
+        result.paths = goal->paths;
+        result.sumOfCosts = sumOfCosts(result.paths);
+        result.lowerBound = goalLowerBound;
+        for (const auto& path : result.paths) {
+            result.makespan = std::max(result.makespan, pathCost(path));
+        }
+    }
+    result.stats.workerSeconds = secondsSince(startTime);
+    result.stats.runtimeSeconds = result.stats.workerSeconds;
+    return result;
+}
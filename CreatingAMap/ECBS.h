@@ -0,0 +1,24 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "HeuristicCache.h"
+#include "SearchControl.h"
+
+struct ECBSOptions {
+    double suboptimality = 1.2;     // w: the solution costs at most w times the optimum
+    int maxNodes = 100000;          // CT node expansion limit
+    double timeLimitSeconds = 60.0;
+    HeuristicCache* heuristics = nullptr;  // Shared distance tables; a private cache is used if null
+    SearchControl* control = nullptr;      // Progress and cancellation, optional
+};
+
+// Enhanced CBS (Barer et al. 2014), a bounded-suboptimal CBS. Both levels are
+// focal searches with the number of conflicts as focal heuristic: the low level
+// (findPathWithFocal) returns a path within w of the agent's shortest path
+// together with a lower bound on it, and the high level expands, among the CT
+// nodes whose cost is within w of the smallest sum of lower bounds (LB), the
+// one with the fewest conflicts. The result's lowerBound is that LB when the
+// solution was found, so sumOfCosts <= w * lowerBound <= w * optimum.
+SolverResult solveECBS(const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid, const ECBSOptions& options = ECBSOptions());
@@ -0,0 +1,51 @@
+#include "Grid.h"
+#include <cstdlib>
+
+Grid::Grid(int width, int height)
+    : width(width), height(height), stride(width + 2),
+    cells(static_cast<size_t>(width + 2) * (height + 2), 1), componentCount(0) {
+
+    neighborOffsets[0] = 1;
+    neighborOffsets[1] = stride;
+    neighborOffsets[2] = -1;
+    neighborOffsets[3] = -stride;
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            cells[toId(x, y)] = 0;
+        }
+    }
+}
+
+int Grid::manhattan(int a, int b) const {
+    return std::abs(a % stride - b % stride) + std::abs(a / stride - b / stride);
+}
+
+void Grid::computeComponents() {
+    components.assign(cells.size(), NO_COMPONENT);
+    componentCount = 0;
+    std::vector<int> stack;
+    for (int start = 0; start < getCellCount(); ++start) {
+        if (cells[start] != 0 || components[start] != NO_COMPONENT) continue;
+
+        // Flood fill; the blocked border keeps every neighbour index valid
+        const int32_t label = componentCount++;
+        components[start] = label;
+        stack.push_back(start);
+        while (!stack.empty()) {
+            int cell = stack.back();
+            stack.pop_back();
+            for (int d = 0; d < NUM_DIRECTIONS; ++d) {
+                int neighbor = cell + neighborOffsets[d];
+                if (cells[neighbor] != 0 || components[neighbor] != NO_COMPONENT) continue;
+                components[neighbor] = label;
+                stack.push_back(neighbor);
+            }
+        }
+    }
+}
+
+void Grid::setComponents(std::vector<int32_t> labels, int count) {
+    components = std::move(labels);
+    componentCount = count;
+}
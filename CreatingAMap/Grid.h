@@ -0,0 +1,68 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include <vector>
+#include <cstdint>
+
+// 4-connected grid map stored in one contiguous array. The map is surrounded by
+// a one-cell blocked border, so a neighbour of any free cell is always a valid
+// index and the planners never need bounds checks. Cells are addressed by linear
+// ids: id = (y + 1) * stride + (x + 1).
+class Grid {
+public:
+    static constexpr int NUM_DIRECTIONS = 4;
+
+    Grid() : width(0), height(0), stride(2), componentCount(0) {}
+    Grid(int width, int height);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getCellCount() const { return static_cast<int>(cells.size()); }  // Including the border
+
+    int toId(const Position& p) const { return (p.y + 1) * stride + (p.x + 1); }
+    int toId(int x, int y) const { return (y + 1) * stride + (x + 1); }
+    Position toPosition(int id) const { return { id % stride - 1, id / stride - 1 }; }
+
+    bool inBounds(const Position& p) const {
+        return p.x >= 0 && p.x < width && p.y >= 0 && p.y < height;
+    }
+
+    bool isBlocked(int id) const { return cells[id] != 0; }
+
+    // Safe for any position; everything outside the map counts as blocked.
+    bool isBlocked(const Position& p) const { return !inBounds(p) || cells[toId(p)] != 0; }
+
+    // Changing a cell drops the component labels.
+    void setBlocked(int x, int y, bool blocked) {
+        cells[toId(x, y)] = blocked ? 1 : 0;
+        components.clear();
+    }
+
+    // Connected components of the free cells, indexed by cell id; blocked cells
+    // are labelled NO_COMPONENT. Filled by computeComponents(), or restored from
+    // a map cache with setComponents().
+    static constexpr int32_t NO_COMPONENT = -1;
+    void computeComponents();
+    void setComponents(std::vector<int32_t> labels, int count);
+    bool hasComponents() const { return !components.empty(); }
+    int getComponentCount() const { return componentCount; }
+    int32_t getComponent(int id) const { return components[id]; }
+    const std::vector<int32_t>& getComponentLabels() const { return components; }
+    // Constant-time reachability test of two free cells: false if they lie in
+    // different components. Without labels every pair counts as connected.
+    bool isConnected(int a, int b) const { return components.empty() || components[a] == components[b]; }
+
+    // Id offsets of the right, down, left and up neighbours, in that order.
+    const int* getNeighborOffsets() const { return neighborOffsets; }
+
+    // Manhattan distance between two cell ids.
+    int manhattan(int a, int b) const;
+
+private:
+    int width, height;
+    int stride;
+    std::vector<uint8_t> cells;
+    int neighborOffsets[NUM_DIRECTIONS];
+    std::vector<int32_t> components;
+    int componentCount;
+};
@@ -0,0 +1,120 @@
+#include "HeuristicCache.h"
+
+DistanceTable computeDistanceTable(const Grid& grid, int goalCell) {
+    DistanceTable table;
+    table.goalCell = goalCell;
+    table.distances.assign(grid.getCellCount(), DistanceTable::UNREACHABLE);
+    table.values = table.distances.data();
+    if (grid.isBlocked(goalCell)) return table;
+
+    // Moves are symmetric on a 4-connected grid, so a forward BFS from the goal
+    // gives the backward distances.
+    std::vector<int> queue;
+    queue.reserve(grid.getCellCount());
+    queue.push_back(goalCell);
+    table.distances[goalCell] = 0;
+
+    const int* offsets = grid.getNeighborOffsets();
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int cell = queue[head];
+        int32_t next = table.distances[cell] + 1;
+        for (int d = 0; d < Grid::NUM_DIRECTIONS; ++d) {
+            int neighbor = cell + offsets[d];
+            if (grid.isBlocked(neighbor) || table.distances[neighbor] != DistanceTable::UNREACHABLE) continue;
+            table.distances[neighbor] = next;
+            queue.push_back(neighbor);
+        }
+    }
+    table.values = table.distances.data();
+    return table;
+}
+
+HeuristicCache::HeuristicCache(const Grid& grid, size_t memoryBudgetBytes)
+    : grid(grid), memoryBudget(memoryBudgetBytes), memoryUsage(0),
+    hits(0), misses(0), evictions(0) {}
+
+std::shared_ptr<const DistanceTable> HeuristicCache::get(const Position& goal) {
+    return get(grid.toId(goal));
+}
+
+std::shared_ptr<const DistanceTable> HeuristicCache::get(int goalCell) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = tables.find(goalCell);
+        if (it != tables.end()) {
+            ++hits;
+            lru.splice(lru.begin(), lru, it->second);
+            return *it->second;
+        }
+        ++misses;
+    }
+
+    // The BFS runs unlocked so other threads can keep using the cache
+    auto table = std::make_shared<const DistanceTable>(computeDistanceTable(grid, goalCell));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = tables.find(goalCell);
+    if (it != tables.end()) {
+        // Another thread computed the same table meanwhile
+        lru.splice(lru.begin(), lru, it->second);
+        return *it->second;
+    }
+    if (table->memoryBytes() <= memoryBudget) {
+        lru.push_front(table);
+        tables[goalCell] = lru.begin();
+        memoryUsage += table->memoryBytes();
+        evictToBudget();
+    }
+    return table;
+}
+
+void HeuristicCache::insert(std::shared_ptr<const DistanceTable> table) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tables.count(table->goalCell) || table->memoryBytes() > memoryBudget) return;
+    memoryUsage += table->memoryBytes();
+    lru.push_front(std::move(table));
+    tables[lru.front()->goalCell] = lru.begin();
+    evictToBudget();
+}
+
+void HeuristicCache::evictToBudget() {
+    // Never evicts the table at the front, which was just inserted or used
+    while (memoryUsage > memoryBudget && lru.size() > 1) {
+        const auto& victim = lru.back();
+        memoryUsage -= victim->memoryBytes();
+        tables.erase(victim->goalCell);
+        lru.pop_back();
+        ++evictions;
+    }
+}
+
+void HeuristicCache::setMemoryBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    memoryBudget = bytes;
+    evictToBudget();
+}
+
+size_t HeuristicCache::getMemoryBudget() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return memoryBudget;
+}
+
+size_t HeuristicCache::getMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return memoryUsage;
+}
+
+long long HeuristicCache::getHits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+long long HeuristicCache::getMisses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
+
+long long HeuristicCache::getEvictions() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return evictions;
+}
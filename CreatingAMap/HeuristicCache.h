@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Grid.h"
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+
+// Exact distances to one goal cell over the static grid (backward BFS), indexed
+// by cell id. Used as a perfect heuristic by the low-level searches. A table
+// either owns its values or views a table persisted in a memory-mapped map
+// cache, which 'backing' keeps alive. Tables are moved, never copied, so
+// 'values' stays valid.
+struct DistanceTable {
+    static constexpr int32_t UNREACHABLE = INT32_MAX / 2;
+
+    int goalCell = -1;
+    std::vector<int32_t> distances;         // Owned values; empty for a mapped table
+    const int32_t* values = nullptr;        // distances.data() or the mapped values
+    std::shared_ptr<const void> backing;
+
+    DistanceTable() = default;
+    DistanceTable(DistanceTable&&) = default;
+    DistanceTable& operator=(DistanceTable&&) = default;
+    DistanceTable(const DistanceTable&) = delete;
+    DistanceTable& operator=(const DistanceTable&) = delete;
+
+    int32_t at(int cell) const { return values[cell]; }
+    bool reachable(int cell) const { return values[cell] != UNREACHABLE; }
+    // Heap memory only; mapped tables live in the page cache
+    size_t memoryBytes() const { return distances.size() * sizeof(int32_t); }
+};
+
+DistanceTable computeDistanceTable(const Grid& grid, int goalCell);
+
+// Distance tables keyed by goal cell, shared by all planners that work on the
+// same grid. Tables are computed on first use and evicted least-recently-used
+// once the memory budget is exceeded. Returned tables stay valid while the
+// caller holds them, even if they are evicted meanwhile. Thread-safe.
+class HeuristicCache {
+public:
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 256u * 1024u * 1024u;
+
+    explicit HeuristicCache(const Grid& grid, size_t memoryBudgetBytes = DEFAULT_MEMORY_BUDGET);
+
+    std::shared_ptr<const DistanceTable> get(const Position& goal);
+    std::shared_ptr<const DistanceTable> get(int goalCell);
+
+    // Adds a precomputed table, e.g. one persisted in a map cache.
+    void insert(std::shared_ptr<const DistanceTable> table);
+
+    void setMemoryBudget(size_t bytes);
+    size_t getMemoryBudget() const;
+    size_t getMemoryUsage() const;
+
+    long long getHits() const;
+    long long getMisses() const;
+    long long getEvictions() const;
+
+    const Grid& getGrid() const { return grid; }
+
+private:
+    typedef std::list<std::shared_ptr<const DistanceTable>> LruList;
+
+    void evictToBudget();
+
+    const Grid& grid;
+    mutable std::mutex mutex;
+    size_t memoryBudget;
+    size_t memoryUsage;
+    LruList lru;  // Most recently used first
+    std::unordered_map<int, LruList::iterator> tables;
+    long long hits, misses, evictions;
+};
@@ -0,0 +1,272 @@
+#include "ICTS.h"
+#include "MDD.h"
+#include "ThreadPool.h"
+#include "Profiling.h"
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <unordered_set>
+#include <atomic>
+#include <mutex>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    struct IntVectorHash {
+        size_t operator()(const std::vector<int>& values) const {
+            size_t hash = values.size();
+            for (int value : values) hash = hash * 1000003u ^ static_cast<size_t>(value);
+            return hash;
+        }
+    };
+
+    typedef std::unordered_set<std::vector<int>, IntVectorHash> IntVectorSet;
+
+    // Depth-first search over the cross product of the agents' MDDs for one
+    // conflict-free combination of paths. Joint states already shown to be dead
+    // ends are remembered, so each is expanded at most once. Gives up at the
+    // deadline, when 'stop' is raised or when the search is cancelled.
+    class JointSearch {
+    public:
+        JointSearch(const Grid& grid, const std::vector<const MDD*>& mdds, Clock::time_point deadline,
+            const std::atomic<bool>& stop, const SearchControl* control)
+            : grid(grid), mdds(mdds), deadline(deadline), stop(stop), control(control),
+            horizon(0), expanded(0), aborted(false) {
+            for (const MDD* mdd : mdds) horizon = std::max(horizon, mdd->cost);
+        }
+
+        bool run(std::vector<Path>& paths) {
+            trajectory.assign(horizon + 1, std::vector<int>(mdds.size()));
+            for (size_t i = 0; i < mdds.size(); ++i) trajectory[0][i] = mdds[i]->levels[0][0];
+            if (!search(0)) return false;
+
+            paths.assign(mdds.size(), Path());
+            for (size_t i = 0; i < mdds.size(); ++i) {
+                for (int t = 0; t <= horizon; ++t) paths[i].push_back(grid.toPosition(trajectory[t][i]));
+                // An agent may arrive before its MDD cost and wait; trim those waits
+                while (paths[i].size() > 1 && paths[i].back() == paths[i][paths[i].size() - 2]) paths[i].pop_back();
+            }
+            return true;
+        }
+
+        long long getExpanded() const { return expanded; }
+
+    private:
+        bool search(int t) {
+            if (t == horizon) return true;
+            if ((++expanded & 1023) == 0 && (stop.load() || isCancelled(control) || Clock::now() > deadline)) {
+                aborted = true;
+            }
+            if (aborted) return false;
+
+            std::vector<int> key = trajectory[t];
+            key.push_back(t);
+            if (!deadEnds.insert(key).second) return false;
+            return assign(t, 0);
+        }
+
+        // Picks the next cell of agents 'agent'.. in turn, skipping moves that
+        // collide with an agent already placed at t + 1.
+        bool assign(int t, size_t agent) {
+            if (agent == mdds.size()) return search(t + 1);
+
+            const std::vector<int>& current = trajectory[t];
+            std::vector<int>& next = trajectory[t + 1];
+            const MDD& mdd = *mdds[agent];
+            const int* offsets = grid.getNeighborOffsets();
+            for (int dir = -1; dir < Grid::NUM_DIRECTIONS; ++dir) {
+                int cell = dir < 0 ? current[agent] : current[agent] + offsets[dir];
+                if (!mdd.contains(t + 1, cell)) continue;
+
+                bool collides = false;
+                for (size_t other = 0; other < agent && !collides; ++other) {
+                    collides = next[other] == cell || (next[other] == current[agent] && cell == current[other]);
+                }
+                if (collides) continue;
+
+                next[agent] = cell;
+                if (assign(t, agent + 1)) return true;
+                if (aborted) return false;
+            }
+            return false;
+        }
+
+        const Grid& grid;
+        const std::vector<const MDD*>& mdds;
+        Clock::time_point deadline;
+        const std::atomic<bool>& stop;
+        const SearchControl* control;
+        int horizon;
+        long long expanded;
+        bool aborted;
+        std::vector<std::vector<int>> trajectory;  // Joint cells at every timestep of the current branch
+        IntVectorSet deadEnds;
+    };
+
+    // Goal test of an ICT node: do the MDDs of these costs hold a solution?
+    bool evaluateNode(const Grid& grid, MDDCache& mddCache, const std::vector<int>& costs,
+        const ICTSOptions& options, Clock::time_point deadline, const std::atomic<bool>& stop,
+        SolverStats& stats, std::vector<Path>& paths) {
+
+        const int numAgents = static_cast<int>(costs.size());
+        MDDLimits limits;
+        limits.deadline = deadline;
+        limits.stop = &stop;
+        limits.control = options.control;
+        std::vector<std::shared_ptr<const MDD>> shared(numAgents);
+        for (int i = 0; i < numAgents; ++i) {
+            shared[i] = mddCache.get(i, costs[i], limits);
+            if (!shared[i]) return false;
+        }
+
+        // Pruning and the joint search look for a conflict-free combination
+        PROFILE_PHASE(CONFLICT_DETECTION);
+
+        // Pruning works on private copies; the cached MDDs are shared by all nodes
+        std::vector<MDD> pruned;
+        std::vector<const MDD*> mdds(numAgents);
+        if (options.pairwisePruning && numAgents > 1) {
+            pruned.reserve(numAgents);
+            for (int i = 0; i < numAgents; ++i) pruned.push_back(*shared[i]);
+            for (int i = 0; i < numAgents; ++i) {
+                for (int j = i + 1; j < numAgents; ++j) {
+                    if (limits.exceeded() || !prunePair(grid, pruned[i], pruned[j], limits)) return false;
+                }
+            }
+            for (int i = 0; i < numAgents; ++i) mdds[i] = &pruned[i];
+        }
+        else {
+            for (int i = 0; i < numAgents; ++i) mdds[i] = shared[i].get();
+        }
+
+        JointSearch search(grid, mdds, deadline, stop, options.control);
+        bool solved = search.run(paths);
+        stats.lowLevelExpanded += search.getExpanded();
+        stats.lowLevelCalls++;
+        return solved;
+    }
+}
+
+SolverResult solveICTS(const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid, const ICTSOptions& options) {
+
+    PROFILE_PHASE(HIGH_LEVEL);
+    auto startTime = Clock::now();
+    auto deadline = startTime + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.timeLimitSeconds));
+    SolverResult result;
+    result.stats.threads = std::max(1, options.numThreads);
+    const int numAgents = static_cast<int>(starts.size());
+
+    std::unique_ptr<HeuristicCache> privateCache;
+    HeuristicCache* heuristics = options.heuristics;
+    if (!heuristics) {
+        privateCache.reset(new HeuristicCache(grid));
+        heuristics = privateCache.get();
+    }
+
+    MDDCache mddCache(grid, *heuristics, starts, goals);
+    std::vector<int> minCosts(numAgents);
+    for (int i = 0; i < numAgents; ++i) {
+        minCosts[i] = mddCache.getMinimumCost(i);
+        if (minCosts[i] < 0) {
+            result.stats.runtimeSeconds = secondsSince(startTime);
+            return result;  // Some agent cannot reach its goal at all
+        }
+    }
+
+    std::unique_ptr<ThreadPool> pool;
+    if (result.stats.threads > 1) pool.reset(new ThreadPool(result.stats.threads));
+    std::vector<SolverStats> workerStats(result.stats.threads);
+
+    // The ICT is searched one sum-of-costs level at a time, so the first solved
+    // node is optimal. A cost vector is reached by many increment orders; each
+    // level keeps every vector once.
+    std::vector<std::vector<int>> level(1, minCosts);
+    result.stats.highLevelGenerated = 1;
+    PROFILE_COUNT(ICT_NODES_GENERATED, 1);
+    std::atomic<int> evaluated(0);
+
+    while (!level.empty() && evaluated.load() < options.maxNodes && Clock::now() < deadline
+        && !isCancelled(options.control)) {
+        int levelCost = 0;
+        for (int cost : level.front()) levelCost += cost;
+        std::atomic<size_t> nextNode(0);
+        std::atomic<bool> found(false);
+        std::mutex resultMutex;
+
+        // Workers take nodes of the level in order until one is solved
+        auto evaluateLevel = [&](int worker) {
+            PROFILE_PHASE(HIGH_LEVEL);
+            auto workerStart = Clock::now();
+            SolverStats& local = workerStats[worker];
+            std::vector<Path> paths;
+            while (!found.load() && Clock::now() < deadline && !isCancelled(options.control)) {
+                size_t index = nextNode++;
+                if (index >= level.size() || evaluated++ >= options.maxNodes) break;
+                PROFILE_COUNT(ICT_NODES_EVALUATED, 1);
+                publishProgress(options.control, evaluated.load(), levelCost, -1);
+                if (evaluateNode(grid, mddCache, level[index], options, deadline, found, local, paths)) {
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    if (!found.load()) {
+                        result.paths = paths;
+                        found = true;
+                    }
+                }
+            }
+            local.workerSeconds += secondsSince(workerStart);
+            };
+
+        if (pool) {
+            for (int worker = 0; worker < pool->getThreadCount(); ++worker) {
+                pool->submit([&evaluateLevel, worker]() { evaluateLevel(worker); });
+            }
+            pool->wait();
+        }
+        else {
+            evaluateLevel(0);
+        }
+
+        if (found.load()) {
+            result.solved = true;
+            break;
+        }
+
+        // Children raise the cost of one agent by one
+        std::vector<std::vector<int>> nextLevel;
+        IntVectorSet seen;
+        for (const auto& costs : level) {
+            for (int i = 0; i < numAgents; ++i) {
+                std::vector<int> child = costs;
+                child[i]++;
+                if (seen.insert(child).second) nextLevel.push_back(std::move(child));
+            }
+        }
+        result.stats.highLevelGenerated += static_cast<int>(nextLevel.size());
+        PROFILE_COUNT(ICT_NODES_GENERATED, static_cast<long long>(nextLevel.size()));
+        level.swap(nextLevel);
+    }
+
+    result.stats.highLevelExpanded = std::min(evaluated.load(), options.maxNodes);
+    for (const auto& local : workerStats) {
+        result.stats.lowLevelExpanded += local.lowLevelExpanded;
+        result.stats.lowLevelCalls += local.lowLevelCalls;
+        result.stats.workerSeconds += local.workerSeconds;
+    }
+    if (result.solved) {
+        for (const auto& path : result.paths) {
+            result.sumOfCosts += pathCost(path);
+            result.makespan = std::max(result.makespan, pathCost(path));
+        }
+        result.lowerBound = result.sumOfCosts;
+    }
+    else {
+        result.paths.clear();
+    }
+    result.stats.runtimeSeconds = secondsSince(startTime);
+    return result;
+}
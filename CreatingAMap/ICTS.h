@@ -0,0 +1,25 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "HeuristicCache.h"
+#include "SearchControl.h"
+
+struct ICTSOptions {
+    int maxNodes = 10000;           // ICT node evaluation limit
+    double timeLimitSeconds = 60.0;
+    HeuristicCache* heuristics = nullptr;  // Shared distance tables; a private cache is used if null
+    bool pairwisePruning = true;           // Prune the MDDs pairwise before the joint search
+    int numThreads = 1;                    // Above 1, the nodes of a cost level are evaluated in parallel
+    SearchControl* control = nullptr;      // Progress and cancellation, optional
+};
+
+// Increasing Cost Tree Search (Sharon et al. 2013). The high level searches cost
+// vectors in order of their sum; a node is solved when the agents' MDDs of those
+// costs contain a conflict-free combination of paths, found by a depth-first
+// search over the joint MDD. The tree is searched level by level without
+// duplicate cost vectors; with several threads the nodes of one level are
+// evaluated concurrently and the level stops at the first solved node. The
+// returned sum-of-costs is optimal.
+SolverResult solveICTS(const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid, const ICTSOptions& options = ICTSOptions());
@@ -0,0 +1,207 @@
+#include "IndependenceDetection.h"
+#include "ConflictDetector.h"
+#include "ThreadPool.h"
+#include "LowLevel.h"
+#include "Profiling.h"
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <set>
+#include <utility>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void addStats(SolverStats& total, const SolverStats& part) {
+        total.highLevelExpanded += part.highLevelExpanded;
+        total.highLevelGenerated += part.highLevelGenerated;
+        total.lowLevelExpanded += part.lowLevelExpanded;
+        total.lowLevelCalls += part.lowLevelCalls;
+        total.workerSeconds += part.workerSeconds;
+        total.cardinalConflicts += part.cardinalConflicts;
+        total.semiCardinalConflicts += part.semiCardinalConflicts;
+        total.nonCardinalConflicts += part.nonCardinalConflicts;
+        total.bypasses += part.bypasses;
+        total.rectangleSplits += part.rectangleSplits;
+        total.corridorSplits += part.corridorSplits;
+        total.neighborhoods += part.neighborhoods;
+        total.improvements += part.improvements;
+    }
+
+    // Constraints that keep an agent off the given paths up to 'horizon':
+    // their cells, the reverse of their moves, and their goals once reached.
+    ConstraintTable avoidPaths(const std::vector<const Path*>& others, int horizon) {
+        ConstraintTable table;
+        for (const Path* path : others) {
+            const int last = pathCost(*path);
+            for (int t = 0; t <= std::max(last, horizon); ++t) {
+                Position cell = positionAt(*path, t);
+                table.add({ Constraint::VERTEX, 0, cell, cell, t });
+                if (t > 0 && t <= last && (*path)[t - 1] != cell) {
+                    table.add({ Constraint::EDGE, 0, cell, (*path)[t - 1], t });
+                }
+            }
+        }
+        return table;
+    }
+}
+
+SolverResult solveWithIndependenceDetection(Algorithm algorithm, const std::vector<Position>& starts,
+    const std::vector<Position>& goals, const Grid& grid, const SolveOptions& options) {
+
+    PROFILE_PHASE(HIGH_LEVEL);
+    auto startTime = Clock::now();
+    SolverResult result;
+    const int numAgents = static_cast<int>(starts.size());
+
+    std::unique_ptr<HeuristicCache> privateCache;
+    HeuristicCache* heuristics = options.heuristics;
+    if (!heuristics) {
+        privateCache.reset(new HeuristicCache(grid));
+        heuristics = privateCache.get();
+    }
+    SolveOptions groupOptions = options;
+    groupOptions.independenceDetection = false;
+    groupOptions.heuristics = heuristics;
+
+    // groups[g] lists the agents of group g; merged groups are left empty
+    std::vector<std::vector<int>> groups(numAgents);
+    std::vector<int> groupOf(numAgents);
+    std::vector<int> pending;  // Groups to (re)solve this round
+    for (int i = 0; i < numAgents; ++i) {
+        groups[i].push_back(i);
+        groupOf[i] = i;
+        pending.push_back(i);
+    }
+
+    const int poolSize = options.groupThreads > 0
+        ? options.groupThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    ThreadPool pool(poolSize);
+    result.stats.threads = poolSize;
+    ConflictDetector detector(grid);
+    detector.reset(numAgents);
+    std::vector<Path> paths(numAgents);
+    std::vector<int> lowerBounds(numAgents, 0);  // Per group
+    std::vector<Conflict> conflicts;
+    std::set<std::pair<int, int>> triedToAvoid;  // Group pairs whose avoidance replan was spent
+    SearchWorkspace workspace;
+
+    bool solved = false;
+    while (true) {
+        const double remaining = options.timeLimitSeconds - secondsSince(startTime);
+        if (remaining <= 0.0 || isCancelled(options.control)) break;
+
+        // A lone group may use the solver's own threads; several share the pool
+        std::vector<SolverResult> groupResults(pending.size());
+        for (size_t k = 0; k < pending.size(); ++k) {
+            pool.submit([&, k]() {
+                const std::vector<int>& members = groups[pending[k]];
+                std::vector<Position> groupStarts, groupGoals;
+                for (int agent : members) {
+                    groupStarts.push_back(starts[agent]);
+                    groupGoals.push_back(goals[agent]);
+                }
+                SolveOptions local = groupOptions;
+                local.timeLimitSeconds = remaining;
+                local.numThreads = pending.size() == 1 ? options.numThreads : 1;
+                groupResults[k] = solve(algorithm, groupStarts, groupGoals, grid, local);
+                });
+        }
+        pool.wait();
+
+        bool failed = false;
+        for (size_t k = 0; k < pending.size(); ++k) {
+            const SolverResult& groupResult = groupResults[k];
+            addStats(result.stats, groupResult.stats);
+            if (!groupResult.solved) {
+                failed = true;
+                continue;
+            }
+            const std::vector<int>& members = groups[pending[k]];
+            for (size_t m = 0; m < members.size(); ++m) {
+                paths[members[m]] = groupResult.paths[m];
+            }
+            lowerBounds[pending[k]] = groupResult.lowerBound;
+        }
+        if (failed) break;  // A group timed out or has no solution, so neither has the whole problem
+
+        detector.syncPaths(paths);
+        conflicts.clear();
+        detector.findAllConflicts(conflicts);
+        if (conflicts.empty()) {
+            solved = true;
+            break;
+        }
+
+        // Each group takes part in at most one replan or merge per round, so the
+        // groups stay as small as the conflicts allow; the remaining conflicts
+        // are handled next round
+        std::sort(conflicts.begin(), conflicts.end(), [](const Conflict& a, const Conflict& b) {
+            return a.timestep < b.timestep;
+            });
+        std::vector<char> touched(numAgents, 0);
+        pending.clear();
+        for (const Conflict& conflict : conflicts) {
+            int keep = groupOf[conflict.agent1];
+            int absorbed = groupOf[conflict.agent2];
+            if (keep == absorbed || touched[keep] || touched[absorbed]) continue;
+            touched[keep] = touched[absorbed] = 1;
+
+            // First time this pair meets: a lone agent tries a path of the same
+            // cost around the other group (Standley's full ID) before merging
+            std::pair<int, int> pair(std::min(keep, absorbed), std::max(keep, absorbed));
+            if (triedToAvoid.insert(pair).second) {
+                bool avoided = false;
+                for (int side = 0; side < 2 && !avoided; ++side) {
+                    const int group = side == 0 ? keep : absorbed;
+                    const int other = side == 0 ? absorbed : keep;
+                    if (groups[group].size() != 1) continue;
+                    const int agent = groups[group].front();
+                    std::vector<const Path*> otherPaths;
+                    for (int member : groups[other]) otherPaths.push_back(&paths[member]);
+                    const int cost = pathCost(paths[agent]);
+                    ConstraintTable table = avoidPaths(otherPaths, cost);
+                    Path path = findPathWithConstraints(starts[agent], goals[agent], grid, table, workspace,
+                        heuristics->get(goals[agent]).get(), &result.stats.lowLevelExpanded);
+                    result.stats.lowLevelCalls++;
+                    if (!path.empty() && pathCost(path) == cost) {
+                        paths[agent] = std::move(path);
+                        avoided = true;
+                    }
+                }
+                if (avoided) continue;
+            }
+
+            if (groups[absorbed].size() > groups[keep].size()) std::swap(keep, absorbed);
+            for (int agent : groups[absorbed]) {
+                groupOf[agent] = keep;
+                groups[keep].push_back(agent);
+            }
+            std::vector<int>().swap(groups[absorbed]);
+            lowerBounds[absorbed] = 0;
+            pending.push_back(keep);
+        }
+    }
+
+    for (const auto& group : groups) {
+        if (group.empty()) continue;
+        result.stats.independentGroups++;
+        result.stats.largestGroup = std::max(result.stats.largestGroup, static_cast<int>(group.size()));
+    }
+    if (solved) {
+        result.solved = true;
+        result.paths = paths;
+        for (const auto& path : paths) {
+            result.sumOfCosts += pathCost(path);
+            result.makespan = std::max(result.makespan, pathCost(path));
+        }
+        for (int bound : lowerBounds) result.lowerBound += bound;
+    }
+    result.stats.runtimeSeconds = secondsSince(startTime);
+    return result;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Solvers.h"
+
+// Independence detection (Standley 2010) in front of any of the solvers. Every
+// agent starts as a group of its own and is planned alone; groups whose paths
+// conflict are merged and the merged group is solved jointly, until the paths of
+// all groups are conflict-free. The first time two groups meet, a group of one
+// agent instead tries to replan around the other at the same cost. Each round
+// handles disjoint pairs of conflicting groups, earliest conflict first, and
+// solves the merged groups concurrently on a thread pool. With an optimal
+// solver the sum of costs stays optimal, since every group is solved optimally
+// and ignoring the others only lowers its cost.
+// 'options.heuristics' is shared by all groups; the time limit covers the whole
+// run. The stats are summed over the group solves.
+SolverResult solveWithIndependenceDetection(Algorithm algorithm, const std::vector<Position>& starts,
+    const std::vector<Position>& goals, const Grid& grid, const SolveOptions& options = SolveOptions());
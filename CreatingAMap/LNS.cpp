@@ -0,0 +1,409 @@
+#include "LNS.h"
+#include "LowLevel.h"
+#include "PrioritizedPlanning.h"
+#include "CBS.h"
+#include "ConflictDetector.h"
+#include "ReservationTable.h"
+#include "ThreadPool.h"
+#include "Profiling.h"
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    const int NUM_NEIGHBORHOODS = 3;    // Kinds the adaptive mode chooses from
+    const double REACTION = 0.1;        // How fast the adaptive weights follow recent improvements
+    const double MIN_WEIGHT = 0.01;     // Keeps every kind in play
+    const int WALK_ATTEMPTS = 10;       // Random walks per agent-based neighbourhood
+
+    // Everything the workers share that never changes during the search.
+    struct LNSProblem {
+        const std::vector<Position>& starts;
+        const std::vector<Position>& goals;
+        const Grid& grid;
+        HeuristicCache& heuristics;
+        const LNSOptions& options;
+        std::vector<int> distances;      // Per agent, its shortest path length
+        int lowerBound;                  // Their sum; a solution this cheap is optimal
+        std::vector<int> intersections;  // Free cells with three or more free neighbours
+        Clock::time_point startTime;
+    };
+
+    // The best solution so far, guarded by 'mutex'.
+    struct Incumbent {
+        explicit Incumbent(const Grid& grid) : detector(grid) {}
+
+        std::mutex mutex;
+        std::vector<Path> paths;
+        ConflictDetector detector;  // Always in sync with 'paths'
+        int cost = 0;
+        int version = 0;            // Bumped by every improvement
+        double weights[NUM_NEIGHBORHOODS] = { 1.0, 1.0, 1.0 };
+        SolverStats stats;          // Of the workers, merged when they finish
+        std::vector<CostSample> curve;
+    };
+
+    class LNSWorker {
+    public:
+        LNSWorker(const LNSProblem& problem, Incumbent& incumbent, unsigned seed)
+            : problem(problem), incumbent(incumbent), rng(seed), reservations(problem.grid),
+            detector(problem.grid), tabu(problem.starts.size(), 0), inNeighborhood(problem.starts.size(), 0),
+            visited(problem.grid.getCellCount(), 0) {
+        }
+
+        void run();
+
+    private:
+        Neighborhood chooseNeighborhood();
+        void randomNeighborhood(std::vector<int>& agents);
+        bool agentNeighborhood(std::vector<int>& agents);
+        bool intersectionNeighborhood(std::vector<int>& agents);
+        bool replan(const std::vector<int>& agents);
+        int commit(const std::vector<int>& agents);
+
+        const LNSProblem& problem;
+        Incumbent& incumbent;
+        std::mt19937 rng;
+        SearchWorkspace workspace;
+        ReservationTable reservations;
+        ConflictDetector detector;     // Of the worker's copy of the solution
+        std::vector<Path> paths;       // Copy of the incumbent, 'version' tells which one
+        int version = -1;
+        std::vector<char> tabu;        // Agents already used to seed an agent-based neighbourhood
+        std::vector<char> inNeighborhood;
+        std::vector<int> visited;      // BFS marks, compared against 'visitStamp'
+        int visitStamp = 0;
+        SolverStats stats;
+    };
+
+    Neighborhood LNSWorker::chooseNeighborhood() {
+        if (problem.options.neighborhood != ADAPTIVE_NEIGHBORHOOD) return problem.options.neighborhood;
+
+        // Roulette wheel over the weights (caller holds the incumbent's lock)
+        double total = 0.0;
+        for (double weight : incumbent.weights) total += weight;
+        double pick = std::uniform_real_distribution<double>(0.0, total)(rng);
+        for (int kind = 0; kind < NUM_NEIGHBORHOODS - 1; ++kind) {
+            pick -= incumbent.weights[kind];
+            if (pick < 0.0) return static_cast<Neighborhood>(kind);
+        }
+        return static_cast<Neighborhood>(NUM_NEIGHBORHOODS - 1);
+    }
+
+    void LNSWorker::randomNeighborhood(std::vector<int>& agents) {
+        const int numAgents = static_cast<int>(paths.size());
+        const int size = std::min(problem.options.neighborhoodSize, numAgents);
+        std::vector<int> all(numAgents);
+        std::iota(all.begin(), all.end(), 0);
+        for (int i = 0; i < size; ++i) {
+            std::swap(all[i], all[i + rng() % (numAgents - i)]);
+            agents.push_back(all[i]);
+        }
+    }
+
+    // The agent delayed most by the others, plus the agents met by random walks
+    // that leave its path and could still reach its goal earlier (Li et al. 2021)
+    bool LNSWorker::agentNeighborhood(std::vector<int>& agents) {
+        const int numAgents = static_cast<int>(paths.size());
+        int seedAgent = -1;
+        int worstDelay = 0;
+        for (int agent = 0; agent < numAgents; ++agent) {
+            int delay = pathCost(paths[agent]) - problem.distances[agent];
+            if (!tabu[agent] && delay > worstDelay) {
+                worstDelay = delay;
+                seedAgent = agent;
+            }
+        }
+        if (seedAgent < 0) {
+            std::fill(tabu.begin(), tabu.end(), 0);  // Every delayed agent had its turn
+            return false;
+        }
+        tabu[seedAgent] = 1;
+        agents.push_back(seedAgent);
+        inNeighborhood[seedAgent] = 1;
+
+        const Grid& grid = problem.grid;
+        const int* offsets = grid.getNeighborOffsets();
+        const Path& path = paths[seedAgent];
+        const int cost = pathCost(path);
+        auto goalDistances = problem.heuristics.get(problem.goals[seedAgent]);
+        std::vector<int> moves;
+        for (int attempt = 0; attempt < WALK_ATTEMPTS
+            && static_cast<int>(agents.size()) < problem.options.neighborhoodSize; ++attempt) {
+            int t = static_cast<int>(rng() % path.size());
+            int cell = grid.toId(path[t]);
+            while (static_cast<int>(agents.size()) < problem.options.neighborhoodSize) {
+                moves.clear();
+                for (int d = 0; d <= Grid::NUM_DIRECTIONS; ++d) {
+                    int next = d == Grid::NUM_DIRECTIONS ? cell : cell + offsets[d];
+                    if (!grid.isBlocked(next) && t + 1 + goalDistances->at(next) < cost) moves.push_back(next);
+                }
+                if (moves.empty()) break;
+                cell = moves[rng() % moves.size()];
+                ++t;
+                int other = detector.agentAt(cell, t);
+                if (other >= 0 && !inNeighborhood[other]) {
+                    agents.push_back(other);
+                    inNeighborhood[other] = 1;
+                }
+            }
+        }
+        for (int agent : agents) inNeighborhood[agent] = 0;
+        return agents.size() > 1;
+    }
+
+    // Agents passing through the intersections closest to a random one
+    bool LNSWorker::intersectionNeighborhood(std::vector<int>& agents) {
+        if (problem.intersections.empty()) return false;
+        const Grid& grid = problem.grid;
+        const int* offsets = grid.getNeighborOffsets();
+        const int size = problem.options.neighborhoodSize;
+
+        std::vector<int> queue(1, problem.intersections[rng() % problem.intersections.size()]);
+        std::vector<int> visitors;
+        ++visitStamp;
+        visited[queue[0]] = visitStamp;
+        for (size_t head = 0; head < queue.size() && static_cast<int>(agents.size()) < size; ++head) {
+            const int cell = queue[head];
+            int freeNeighbors = 0;
+            for (int d = 0; d < Grid::NUM_DIRECTIONS; ++d) {
+                int next = cell + offsets[d];
+                if (grid.isBlocked(next)) continue;
+                ++freeNeighbors;
+                if (visited[next] != visitStamp) {
+                    visited[next] = visitStamp;
+                    queue.push_back(next);
+                }
+            }
+            if (freeNeighbors < 3) continue;
+
+            visitors.clear();
+            detector.collectVisitors(cell, visitors);
+            std::shuffle(visitors.begin(), visitors.end(), rng);
+            for (int agent : visitors) {
+                if (inNeighborhood[agent] || static_cast<int>(agents.size()) >= size) continue;
+                agents.push_back(agent);
+                inNeighborhood[agent] = 1;
+            }
+        }
+        for (int agent : agents) inNeighborhood[agent] = 0;
+        return agents.size() > 1;
+    }
+
+    // Replans 'agents' against everybody else's paths in the worker's copy.
+    bool LNSWorker::replan(const std::vector<int>& agents) {
+        for (int agent : agents) inNeighborhood[agent] = 1;
+        reservations.clear();
+        for (size_t agent = 0; agent < paths.size(); ++agent) {
+            if (!inNeighborhood[agent]) reservations.reservePath(paths[agent]);
+        }
+        for (int agent : agents) inNeighborhood[agent] = 0;
+
+        if (!problem.options.cbsReplanning) {
+            std::vector<int> order(agents);
+            std::shuffle(order.begin(), order.end(), rng);
+            const auto deadline = problem.startTime + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(problem.options.timeLimitSeconds));
+            return planInOrder(order, problem.starts, problem.goals, problem.grid, reservations,
+                problem.heuristics, workspace, paths, stats, deadline, problem.options.control);
+        }
+
+        std::vector<Position> starts, goals;
+        for (int agent : agents) {
+            starts.push_back(problem.starts[agent]);
+            goals.push_back(problem.goals[agent]);
+        }
+        CBSOptions cbsOptions;
+        cbsOptions.timeLimitSeconds = std::min(problem.options.replanTimeLimitSeconds,
+            problem.options.timeLimitSeconds - secondsSince(problem.startTime));
+        cbsOptions.heuristics = &problem.heuristics;
+        cbsOptions.control = problem.options.control;
+        cbsOptions.reservations = &reservations;
+        SolverResult result = solveCBS(starts, goals, problem.grid, cbsOptions);
+        stats.lowLevelExpanded += result.stats.lowLevelExpanded;
+        stats.lowLevelCalls += result.stats.lowLevelCalls;
+        if (!result.solved) return false;
+        for (size_t i = 0; i < agents.size(); ++i) {
+            paths[agents[i]] = std::move(result.paths[i]);
+        }
+        return true;
+    }
+
+    // Offers the replanned 'agents' to the incumbent (caller holds its lock).
+    // Returns by how much the sum of costs went down, 0 if nothing was kept.
+    int LNSWorker::commit(const std::vector<int>& agents) {
+        int oldCost = 0, newCost = 0;
+        for (int agent : agents) {
+            oldCost += pathCost(incumbent.paths[agent]);
+            newCost += pathCost(paths[agent]);
+        }
+        if (newCost >= oldCost) return 0;
+
+        const bool upToDate = incumbent.version == version;
+        for (int agent : agents) incumbent.detector.setPath(agent, paths[agent]);
+        if (!upToDate) {
+            // Another worker improved the solution meanwhile; the new paths only
+            // fit if they avoid its changes too
+            std::vector<Conflict> conflicts;
+            for (int agent : agents) incumbent.detector.findConflicts(agent, conflicts);
+            if (!conflicts.empty()) {
+                for (int agent : agents) incumbent.detector.setPath(agent, incumbent.paths[agent]);
+                return 0;
+            }
+        }
+        for (int agent : agents) incumbent.paths[agent] = paths[agent];
+        incumbent.cost -= oldCost - newCost;
+        incumbent.version++;
+        incumbent.curve.push_back({ secondsSince(problem.startTime), incumbent.cost });
+        if (upToDate) version = incumbent.version;  // Our copy is the incumbent again
+        return oldCost - newCost;
+    }
+
+    void LNSWorker::run() {
+        PROFILE_PHASE(HIGH_LEVEL);
+        auto workerStart = Clock::now();
+        const LNSOptions& options = problem.options;
+        std::vector<int> agents;
+        std::vector<Path> previous;
+        while (secondsSince(problem.startTime) < options.timeLimitSeconds && !isCancelled(options.control)) {
+            Neighborhood kind;
+            {
+                std::lock_guard<std::mutex> lock(incumbent.mutex);
+                if (incumbent.cost <= problem.lowerBound) break;
+                if (incumbent.version != version) {
+                    paths = incumbent.paths;
+                    version = incumbent.version;
+                }
+                kind = chooseNeighborhood();
+            }
+            detector.syncPaths(paths);
+
+            agents.clear();
+            bool found = kind == AGENT_NEIGHBORHOOD ? agentNeighborhood(agents)
+                : kind == INTERSECTION_NEIGHBORHOOD ? intersectionNeighborhood(agents) : false;
+            if (!found) {
+                agents.clear();
+                randomNeighborhood(agents);
+            }
+
+            previous.clear();
+            for (int agent : agents) previous.push_back(paths[agent]);
+            const bool replanned = replan(agents);
+            stats.neighborhoods++;
+
+            std::lock_guard<std::mutex> lock(incumbent.mutex);
+            int gain = replanned ? commit(agents) : 0;
+            if (gain > 0) {
+                stats.improvements++;
+                publishProgress(options.control, stats.neighborhoods, incumbent.cost, 0);
+            }
+            else {
+                // Back to the copy we started from
+                for (size_t i = 0; i < agents.size(); ++i) paths[agents[i]] = std::move(previous[i]);
+            }
+            if (options.neighborhood == ADAPTIVE_NEIGHBORHOOD) {
+                double& weight = incumbent.weights[kind];
+                weight = (1.0 - REACTION) * weight + REACTION * gain / static_cast<double>(agents.size());
+                weight = std::max(weight, MIN_WEIGHT);
+            }
+        }
+
+        stats.workerSeconds = secondsSince(workerStart);
+        std::lock_guard<std::mutex> lock(incumbent.mutex);
+        incumbent.stats.neighborhoods += stats.neighborhoods;
+        incumbent.stats.improvements += stats.improvements;
+        incumbent.stats.lowLevelExpanded += stats.lowLevelExpanded;
+        incumbent.stats.lowLevelCalls += stats.lowLevelCalls;
+        incumbent.stats.workerSeconds += stats.workerSeconds;
+    }
+}
+
+SolverResult solveLNS(const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid, const LNSOptions& options) {
+
+    PROFILE_PHASE(HIGH_LEVEL);
+    auto startTime = Clock::now();
+    const int numAgents = static_cast<int>(starts.size());
+
+    std::unique_ptr<HeuristicCache> privateCache;
+    HeuristicCache* heuristics = options.heuristics;
+    if (!heuristics) {
+        privateCache.reset(new HeuristicCache(grid));
+        heuristics = privateCache.get();
+    }
+
+    PrioritizedOptions initialOptions;
+    initialOptions.timeLimitSeconds = options.timeLimitSeconds;
+    initialOptions.seed = options.seed;
+    initialOptions.heuristics = heuristics;
+    initialOptions.control = options.control;
+    SolverResult result = solvePrioritized(starts, goals, grid, initialOptions);
+    if (!result.solved) {
+        result.stats.runtimeSeconds = secondsSince(startTime);
+        return result;
+    }
+    result.costCurve.push_back({ secondsSince(startTime), result.sumOfCosts });
+
+    LNSProblem problem = { starts, goals, grid, *heuristics, options, std::vector<int>(numAgents),
+        result.lowerBound, std::vector<int>(), startTime };
+    for (int i = 0; i < numAgents; ++i) {
+        problem.distances[i] = heuristics->get(goals[i])->at(grid.toId(starts[i]));
+    }
+    const int* offsets = grid.getNeighborOffsets();
+    for (int cell = 0; cell < grid.getCellCount(); ++cell) {
+        if (grid.isBlocked(cell)) continue;
+        int freeNeighbors = 0;
+        for (int d = 0; d < Grid::NUM_DIRECTIONS; ++d) {
+            if (!grid.isBlocked(cell + offsets[d])) ++freeNeighbors;
+        }
+        if (freeNeighbors >= 3) problem.intersections.push_back(cell);
+    }
+
+    Incumbent incumbent(grid);
+    incumbent.paths = std::move(result.paths);
+    incumbent.detector.syncPaths(incumbent.paths);
+    incumbent.cost = result.sumOfCosts;
+
+    // A single agent is already on its shortest path
+    if (numAgents > 1 && incumbent.cost > problem.lowerBound) {
+        const int numThreads = std::max(1, options.numThreads);
+        if (numThreads == 1) {
+            LNSWorker(problem, incumbent, options.seed).run();
+        }
+        else {
+            ThreadPool pool(numThreads);
+            std::vector<std::unique_ptr<LNSWorker>> workers;
+            for (int i = 0; i < numThreads; ++i) {
+                workers.emplace_back(new LNSWorker(problem, incumbent, options.seed + 1 + i));
+                LNSWorker* worker = workers.back().get();
+                pool.submit([worker]() { worker->run(); });
+            }
+            pool.wait();
+        }
+    }
+
+    result.paths = std::move(incumbent.paths);
+    result.sumOfCosts = incumbent.cost;
+    result.makespan = 0;
+    for (const auto& path : result.paths) {
+        result.makespan = std::max(result.makespan, pathCost(path));
+    }
+    result.costCurve.insert(result.costCurve.end(), incumbent.curve.begin(), incumbent.curve.end());
+    result.stats.neighborhoods = incumbent.stats.neighborhoods;
+    result.stats.improvements = incumbent.stats.improvements;
+    result.stats.lowLevelExpanded += incumbent.stats.lowLevelExpanded;
+    result.stats.lowLevelCalls += incumbent.stats.lowLevelCalls;
+    result.stats.workerSeconds = result.stats.runtimeSeconds + incumbent.stats.workerSeconds;  // Initial solution, then the workers
+    result.stats.threads = std::max(1, options.numThreads);
+    result.stats.runtimeSeconds = secondsSince(startTime);
+    return result;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "HeuristicCache.h"
+#include "SearchControl.h"
+
+// How LNS picks the agents to replan together.
+enum Neighborhood {
+    RANDOM_NEIGHBORHOOD,        // Agents drawn uniformly
+    AGENT_NEIGHBORHOOD,         // The most delayed agent and the agents in its way
+    INTERSECTION_NEIGHBORHOOD,  // Agents passing the intersections around a random one
+    ADAPTIVE_NEIGHBORHOOD       // One of the above, chosen by how much each has improved so far
+};
+
+struct LNSOptions {
+    double timeLimitSeconds = 60.0;        // Wall-clock budget, initial solution included
+    int neighborhoodSize = 8;              // Agents replanned together
+    Neighborhood neighborhood = ADAPTIVE_NEIGHBORHOOD;
+    bool cbsReplanning = false;            // Replan neighbourhoods optimally with CBS instead of prioritized planning
+    double replanTimeLimitSeconds = 1.0;   // Per CBS replan
+    int numThreads = 1;                    // Neighbourhoods replanned concurrently
+    unsigned seed = 0;
+    HeuristicCache* heuristics = nullptr;  // Shared distance tables; a private cache is used if null
+    SearchControl* control = nullptr;      // Progress and cancellation, optional
+};
+
+// Anytime MAPF-LNS (Li et al. 2021). Starts from a prioritized planning
+// solution, then until the time runs out repeatedly removes the paths of a
+// neighbourhood of agents and replans them against the paths of all the other
+// agents, with prioritized planning in a random order or with CBS. A new
+// solution is kept whenever it lowers the sum of costs. With several threads
+// every worker replans its own neighbourhoods on a copy of the best solution
+// and only keeps its result if it still fits the best solution at that time.
+// The search stops early once the sum of costs reaches the lowerBound, the sum
+// of the agents' shortest path lengths. The result's costCurve records the
+// initial solution and every improvement.
+SolverResult solveLNS(const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid, const LNSOptions& options = LNSOptions());
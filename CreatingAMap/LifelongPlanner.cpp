@@ -0,0 +1,173 @@
+#include "LifelongPlanner.h"
+#include "LowLevel.h"
+#include "Profiling.h"
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    const int MAX_ROUNDS = 6;  // Collision checks per replan
+}
+
+LifelongPlanner::LifelongPlanner(const Grid& grid, HeuristicCache& heuristics, const LifelongOptions& options)
+    : grid(grid), heuristics(heuristics), options(options), reservations(grid) {
+    this->options.horizon = std::max(1, options.horizon);
+    this->options.replanPeriod = std::min(std::max(1, options.replanPeriod), this->options.horizon);
+}
+
+void LifelongPlanner::reset(const std::vector<Position>& positions) {
+    reservations.clear();
+    history.clear();
+    timestep = 0;
+    lastCheck = 0;
+    plans.clear();
+    for (const Position& position : positions) {
+        plans.push_back({ Path(1, position), 0, position, false, false });
+        reservations.reservePath(plans.back().path, 0);
+    }
+}
+
+void LifelongPlanner::assignGoal(int agent, const Position& goal) {
+    plans[agent].goal = goal;
+    plans[agent].hasGoal = true;
+    plans[agent].pending = true;
+}
+
+Position LifelongPlanner::positionAt(const Plan& plan, int t) const {
+    return ::positionAt(plan.path, t - plan.startTime);
+}
+
+Position LifelongPlanner::getPosition(int agent) const {
+    return positionAt(plans[agent], timestep);
+}
+
+bool LifelongPlanner::isIdle(int agent) const {
+    const Plan& plan = plans[agent];
+    return !plan.pending && timestep >= plan.startTime + pathCost(plan.path);
+}
+
+bool LifelongPlanner::needsReplan() const {
+    if (timestep - lastCheck >= options.replanPeriod) return true;
+    for (const Plan& plan : plans) {
+        if (plan.pending) return true;
+    }
+    return false;
+}
+
+void LifelongPlanner::findCollidingAgents(std::vector<char>& colliding) const {
+    PROFILE_PHASE(CONFLICT_DETECTION);
+    // Who is where at each timestep of the window; paths beyond the window of
+    // an earlier replan may overlap, which is what this looks for
+    std::unordered_map<int, int> occupant, previousOccupant;
+    const int numAgents = getNumAgents();
+    for (int t = timestep; t <= timestep + options.horizon; ++t) {
+        previousOccupant.swap(occupant);
+        occupant.clear();
+        for (int agent = 0; agent < numAgents; ++agent) {
+            const int cell = grid.toId(positionAt(plans[agent], t));
+            auto inserted = occupant.emplace(cell, agent);
+            if (!inserted.second) {
+                colliding[agent] = 1;
+                colliding[inserted.first->second] = 1;
+            }
+        }
+        if (t == timestep) continue;
+        for (int agent = 0; agent < numAgents; ++agent) {
+            // Swap: the agent that was at our cell is now where we were
+            const int from = grid.toId(positionAt(plans[agent], t - 1));
+            const int to = grid.toId(positionAt(plans[agent], t));
+            if (from == to) continue;
+            auto other = previousOccupant.find(to);
+            if (other != previousOccupant.end() && other->second != agent
+                && grid.toId(positionAt(plans[other->second], t)) == from) {
+                colliding[agent] = 1;
+                colliding[other->second] = 1;
+            }
+        }
+    }
+}
+
+ReplanRecord LifelongPlanner::replan() {
+    PROFILE_PHASE(HIGH_LEVEL);
+    auto startTime = Clock::now();
+    ReplanRecord record = { timestep, 0, 0, 0, 0, 0.0 };
+    const int numAgents = getNumAgents();
+    lastCheck = timestep;
+
+    // Agents that wait for lack of a path can end up in someone's way, so the
+    // window is checked again after each round
+    std::vector<char> affected(numAgents);
+    std::vector<char> stuck(numAgents, 0);  // Found no path in the previous round
+    std::vector<int> order;
+    std::vector<int> distance(numAgents, 0);
+    for (int round = 0; round <= MAX_ROUNDS; ++round) {
+        std::fill(affected.begin(), affected.end(), 0);
+        findCollidingAgents(affected);
+        order.clear();
+        for (int agent = 0; agent < numAgents; ++agent) {
+            if (affected[agent] || (round == 0 && plans[agent].pending)) order.push_back(agent);
+        }
+        if (order.empty()) break;
+        if (round == MAX_ROUNDS) {
+            record.collidingAgents = static_cast<int>(order.size());  // Out of rounds
+            break;
+        }
+
+        // Release first, so the replanned agents only avoid the paths that
+        // stay. Each restarts from where it is now.
+        for (int agent : order) {
+            Plan& plan = plans[agent];
+            reservations.releasePath(plan.path, plan.startTime);
+            Position current = positionAt(plan, timestep);
+            plan.path.assign(1, current);
+            plan.startTime = timestep;
+            distance[agent] = plan.hasGoal ? heuristics.get(plan.goal)->at(grid.toId(current)) : 0;
+        }
+
+        // Stuck agents first, since the others can route around a waiting agent
+        // but not the other way round; then the agents that still have far to go
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            if (stuck[a] != stuck[b]) return stuck[a] > stuck[b];
+            return distance[a] > distance[b];
+            });
+        std::fill(stuck.begin(), stuck.end(), 0);
+        for (int agent : order) {
+            Plan& plan = plans[agent];
+            record.replannedAgents++;
+            if (plan.hasGoal) {
+                Path path;
+                if (secondsSince(startTime) <= options.timeLimitSeconds) {
+                    path = findPathWithReservations(plan.path[0], plan.goal, grid, reservations, workspace,
+                        heuristics.get(plan.goal).get(), &record.lowLevelExpanded, timestep, options.horizon);
+                }
+                if (!path.empty()) {
+                    plan.path = std::move(path);
+                    plan.pending = false;
+                }
+                else {
+                    // The agent waits where it is for a later replan
+                    plan.pending = true;
+                    stuck[agent] = 1;
+                }
+            }
+            reservations.reservePath(plan.path, plan.startTime);
+        }
+    }
+
+    for (const Plan& plan : plans) {
+        if (plan.pending) record.failedAgents++;
+    }
+    record.latencySeconds = secondsSince(startTime);
+    history.push_back(record);
+    return record;
+}
+
+void LifelongPlanner::step() {
+    timestep++;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "HeuristicCache.h"
+#include "SearchWorkspace.h"
+#include "ReservationTable.h"
+#include <vector>
+
+struct LifelongOptions {
+    int horizon = 20;               // Collisions are resolved this many timesteps ahead (w)
+    int replanPeriod = 5;           // Timesteps between window checks (h); at most 'horizon'
+    double timeLimitSeconds = 1.0;  // Per replan; agents left over wait for the next one
+};
+
+// One call of LifelongPlanner::replan().
+struct ReplanRecord {
+    int timestep;
+    int replannedAgents;   // New goals plus agents with a collision in the window
+    int failedAgents;      // Left without a path; they wait and are tried again
+    int collidingAgents;   // Still on a collision course within the window, if the rounds ran out
+    long long lowLevelExpanded;
+    double latencySeconds;
+};
+
+// Online planning for agents that keep receiving new goals (lifelong MAPF),
+// after Rolling-Horizon Collision Resolution (Li et al. 2021). Paths are kept in
+// one reservation table over absolute timesteps. A replan only touches the
+// agents that got a new goal or that collide with someone within the next
+// 'horizon' timesteps: their paths are released and planned again, one after
+// another, against the paths of everybody else. Everything else carries over
+// from the previous replan: the other agents' paths and reservations, the
+// distance tables of the goals and the search memory. Replanning at least every
+// 'replanPeriod' <= 'horizon' timesteps keeps the executed moves collision-free,
+// as long as each replan resolves its window; like RHCR this is not complete,
+// and in very crowded windows collisions can be left over (collidingAgents).
+class LifelongPlanner {
+public:
+    LifelongPlanner(const Grid& grid, HeuristicCache& heuristics, const LifelongOptions& options = LifelongOptions());
+
+    // Starts over at timestep 0 with the agents at 'positions' and no goals.
+    void reset(const std::vector<Position>& positions);
+    // The agent heads for 'goal' from the next replan on.
+    void assignGoal(int agent, const Position& goal);
+
+    // Whether replan() has work: new goals, or the window is due for a check.
+    // replan() may also be called every timestep.
+    bool needsReplan() const;
+    ReplanRecord replan();
+    // Advances the clock; every agent moves one step along its path.
+    void step();
+
+    int getTimestep() const { return timestep; }
+    int getNumAgents() const { return static_cast<int>(plans.size()); }
+    Position getPosition(int agent) const;
+    // At its goal with nothing left to do.
+    bool isIdle(int agent) const;
+    const std::vector<ReplanRecord>& getHistory() const { return history; }
+
+private:
+    struct Plan {
+        Path path;
+        int startTime;   // Timestep at which the agent is at path[0]
+        Position goal;
+        bool hasGoal;
+        bool pending;    // Goal not planned for yet
+    };
+
+    Position positionAt(const Plan& plan, int t) const;
+    // Agents that collide with another one during the window.
+    void findCollidingAgents(std::vector<char>& colliding) const;
+
+    const Grid& grid;
+    HeuristicCache& heuristics;
+    LifelongOptions options;
+    ReservationTable reservations;
+    SearchWorkspace workspace;
+    std::vector<Plan> plans;
+    std::vector<ReplanRecord> history;
+    int timestep = 0;
+    int lastCheck = 0;   // Timestep of the last replan
+};
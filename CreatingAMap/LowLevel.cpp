@@ -0,0 +1,493 @@
+#include "LowLevel.h"
+#include <algorithm>
+#include <cmath>
+#include <climits>
+
+namespace {
+    // Maps are well below 65536 cells per side, so a cell fits in 32 bits.
+    uint64_t cellKey(const Position& p) {
+        return (static_cast<uint64_t>(static_cast<uint16_t>(p.y)) << 16) | static_cast<uint16_t>(p.x);
+    }
+
+    uint64_t vertexKey(const Position& p, int t) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(t)) << 32) | cellKey(p);
+    }
+
+    // Direction of the move from -> to, 0..4 (4 = wait).
+    uint64_t moveIndex(const Position& from, const Position& to) {
+        int dx = to.x - from.x, dy = to.y - from.y;
+        if (dx == 1) return 0;
+        if (dy == 1) return 1;
+        if (dx == -1) return 2;
+        if (dy == -1) return 3;
+        return 4;
+    }
+
+    uint64_t edgeKey(const Position& from, const Position& to, int t) {
+        return vertexKey(to, t) | (moveIndex(from, to) << 61);
+    }
+
+#ifdef MAPF_PROFILE
+    // Charges one search to the thread's profile: its time, and when it returns
+    // its expansions, generated nodes and heap operations. The space-time
+    // searches generate the nodes of the pool, the spatial one what it pushes.
+    class LowLevelCall {
+    public:
+        LowLevelCall(const long long& expanded, const SearchWorkspace& workspace,
+            const std::vector<SpaceTimeNode>* nodes)
+            : timer(LOW_LEVEL_SEARCH), expanded(expanded), workspace(workspace), nodes(nodes),
+            pushesBefore(workspace.heapPushes), popsBefore(workspace.heapPops) {
+        }
+        ~LowLevelCall() {
+            SearchProfile* profile = currentProfile();
+            if (!profile) return;
+            const long long pushes = workspace.heapPushes - pushesBefore;
+            profile->addLowLevelCall(expanded);
+            profile->add(LOW_LEVEL_GENERATED, nodes ? static_cast<long long>(nodes->size()) : pushes);
+            profile->add(HEAP_PUSHES, pushes);
+            profile->add(HEAP_POPS, workspace.heapPops - popsBefore);
+        }
+
+    private:
+        PhaseTimer timer;
+        const long long& expanded;
+        const SearchWorkspace& workspace;
+        const std::vector<SpaceTimeNode>* nodes;
+        long long pushesBefore, popsBefore;
+    };
+#endif
+}
+
+void ConstraintTable::add(const Constraint& constraint) {
+    if (constraint.type == Constraint::VERTEX) {
+        vertexKeys.insert(vertexKey(constraint.to, constraint.timestep));
+        auto it = lastVertexTime.find(constraint.to);
+        if (it == lastVertexTime.end() || it->second < constraint.timestep) {
+            lastVertexTime[constraint.to] = constraint.timestep;
+        }
+    }
+    else {
+        edgeKeys.insert(edgeKey(constraint.from, constraint.to, constraint.timestep));
+    }
+    maxTimestep = std::max(maxTimestep, constraint.timestep);
+}
+
+bool ConstraintTable::isVertexConstrained(const Position& pos, int timestep) const {
+    if (reservations && reservations->isReserved(reservations->getGrid().toId(pos), timestep)) return true;
+    return !vertexKeys.empty() && vertexKeys.count(vertexKey(pos, timestep)) > 0;
+}
+
+bool ConstraintTable::isEdgeConstrained(const Position& from, const Position& to, int timestep) const {
+    if (reservations) {
+        const Grid& grid = reservations->getGrid();
+        if (reservations->isMoveReserved(grid.toId(from), grid.toId(to), timestep)) return true;
+    }
+    return !edgeKeys.empty() && edgeKeys.count(edgeKey(from, to, timestep)) > 0;
+}
+
+int ConstraintTable::getMaxTimestep() const {
+    return reservations ? std::max(maxTimestep, reservations->getMaxTimestep()) : maxTimestep;
+}
+
+int ConstraintTable::getEarliestGoalTime(const Position& goal) const {
+    auto it = lastVertexTime.find(goal);
+    int earliest = it == lastVertexTime.end() ? 0 : it->second + 1;
+    if (reservations) {
+        int stay = reservations->getEarliestStayTime(reservations->getGrid().toId(goal));
+        earliest = stay < 0 ? INT_MAX : std::max(earliest, stay);
+    }
+    return earliest;
+}
+
+namespace {
+    uint64_t stateKey(int cell, int t) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(t)) << 32) | static_cast<uint32_t>(cell);
+    }
+
+    // Distance-table lookup when available, Manhattan distance otherwise.
+    struct Heuristic {
+        const Grid& grid;
+        const DistanceTable* table;
+        int goalCell;
+
+        int operator()(int cell) const {
+            return table ? table->at(cell) : grid.manhattan(cell, goalCell);
+        }
+        // With an exact table, cells that cannot reach the goal are never generated.
+        bool deadEnd(int cell) const {
+            return table && !table->reachable(cell);
+        }
+    };
+
+    // f of a space-time node. No path reaches the goal before
+    // 'earliestGoalTime', so that is a lower bound as well; without it a goal
+    // constraint at a late timestep makes A* expand every state with a
+    // smaller g + h, instead of waiting near the goal.
+    struct GoalTimeBound {
+        const Heuristic& h;
+        int earliestGoalTime;
+
+        int operator()(int cell, int g) const {
+            return std::max(g + h(cell), earliestGoalTime);
+        }
+    };
+}
+
+Path findShortestPath(const Position& start, const Position& goal, const Grid& grid,
+    SearchWorkspace& workspace, const DistanceTable* heuristic, long long* expandedCount) {
+
+    if (grid.isBlocked(start) || grid.isBlocked(goal)) return {};
+
+    const int startCell = grid.toId(start);
+    const int goalCell = grid.toId(goal);
+    const Heuristic h = { grid, heuristic, goalCell };
+    // Unreachable goals are rejected up front instead of by exhausting the start's component
+    if (h.deadEnd(startCell) || !grid.isConnected(startCell, goalCell)) return {};
+    const int* offsets = grid.getNeighborOffsets();
+    long long expanded = 0;
+
+    workspace.beginQuery(grid.getCellCount());
+    PROFILE_ONLY(LowLevelCall call(expanded, workspace, nullptr);)
+    workspace.visit(startCell, 0, -1);
+    workspace.pushOpen({ h(startCell), 0, startCell });
+
+    while (!workspace.openEmpty()) {
+        OpenEntry current = workspace.popOpen();
+        int cell = current.node;
+
+        // Entries are never decreased in place; outdated copies are skipped here
+        if (workspace.isClosed(cell) || current.g != workspace.getG(cell)) continue;
+        workspace.close(cell);
+        ++expanded;
+
+        if (cell == goalCell) {
+            Path path;
+            for (int c = cell; c != -1; c = workspace.getParent(c)) {
+                path.push_back(grid.toPosition(c));
+            }
+            std::reverse(path.begin(), path.end());
+            if (expandedCount) *expandedCount += expanded;
+            return path;
+        }
+
+        int newG = current.g + 1;
+        for (int d = 0; d < Grid::NUM_DIRECTIONS; ++d) {
+            int neighbor = cell + offsets[d];
+            if (grid.isBlocked(neighbor) || h.deadEnd(neighbor)) continue;
+            if (workspace.isVisited(neighbor) && workspace.getG(neighbor) <= newG) continue;
+
+            workspace.visit(neighbor, newG, cell);
+            workspace.pushOpen({ newG + h(neighbor), newG, neighbor });
+        }
+    }
+
+    if (expandedCount) *expandedCount += expanded;
+    return {};
+}
+
+Path findPathWithConstraints(const Position& start, const Position& goal, const Grid& grid,
+    const ConstraintTable& constraints, SearchWorkspace& workspace,
+    const DistanceTable* heuristic, long long* expandedCount) {
+
+    if (grid.isBlocked(start) || grid.isBlocked(goal)) return {};
+    if (constraints.isVertexConstrained(start, 0)) return {};
+
+    const int startCell = grid.toId(start);
+    const int goalCell = grid.toId(goal);
+    const Heuristic h = { grid, heuristic, goalCell };
+    if (h.deadEnd(startCell) || !grid.isConnected(startCell, goalCell)) return {};
+    const bool constrained = !constraints.empty();
+
+    // Beyond the last constrained timestep nothing changes any more, so all such
+    // timesteps collapse into one and waiting there is pointless. This keeps the
+    // search finite when the goal is unreachable.
+    const int staticAfter = constraints.getMaxTimestep() + 1;
+    const int earliestGoalTime = constraints.getEarliestGoalTime(goal);
+    if (earliestGoalTime == INT_MAX) return {};  // A reserved agent rests on the goal for good
+    const GoalTimeBound f = { h, earliestGoalTime };
+
+    workspace.beginQuery(grid.getCellCount());
+    std::vector<SpaceTimeNode>& nodes = workspace.nodes;
+    StampedKeySet& closedSet = workspace.closedStates;
+    long long expanded = 0;
+    PROFILE_ONLY(LowLevelCall call(expanded, workspace, &nodes);)
+
+    nodes.push_back({ startCell, 0, -1 });
+    workspace.pushOpen({ f(startCell, 0), 0, 0 });
+
+    const int* offsets = grid.getNeighborOffsets();
+
+    while (!workspace.openEmpty()) {
+        int currentIndex = workspace.popOpen().node;
+        const SpaceTimeNode current = nodes[currentIndex];
+
+        int timeKey = std::min(current.g, staticAfter);
+        if (!closedSet.insert(stateKey(current.cell, timeKey))) continue;
+        ++expanded;
+
+        if (current.cell == goalCell && current.g >= earliestGoalTime) {
+            Path path;
+            for (int i = currentIndex; i != -1; i = nodes[i].parent) {
+                path.push_back(grid.toPosition(nodes[i].cell));
+            }
+            std::reverse(path.begin(), path.end());
+            if (expandedCount) *expandedCount += expanded;
+            return path;
+        }
+
+        const Position currentPos = grid.toPosition(current.cell);
+        const int newG = current.g + 1;
+
+        // Four moves followed by waiting in place
+        for (int d = 0; d <= Grid::NUM_DIRECTIONS; ++d) {
+            bool isWait = d == Grid::NUM_DIRECTIONS;
+            if (isWait && current.g >= staticAfter) continue;
+
+            int neighbor = isWait ? current.cell : current.cell + offsets[d];
+            if (grid.isBlocked(neighbor) || h.deadEnd(neighbor)) continue;
+
+            if (constrained) {
+                Position neighborPos = grid.toPosition(neighbor);
+                if (constraints.isVertexConstrained(neighborPos, newG) ||
+                    constraints.isEdgeConstrained(currentPos, neighborPos, newG)) {
+                    continue;
+                }
+            }
+            if (closedSet.contains(stateKey(neighbor, std::min(newG, staticAfter)))) continue;
+
+            nodes.push_back({ neighbor, newG, currentIndex });
+            workspace.pushOpen({ f(neighbor, newG), newG,
+                static_cast<int>(nodes.size()) - 1 });
+        }
+    }
+
+    if (expandedCount) *expandedCount += expanded;
+    return {};
+}
+
+Path findPathWithReservations(const Position& start, const Position& goal, const Grid& grid,
+    const ReservationTable& reservations, SearchWorkspace& workspace,
+    const DistanceTable* heuristic, long long* expandedCount, int startTime, int horizon,
+    std::chrono::steady_clock::time_point deadline, const SearchControl* control) {
+
+    if (grid.isBlocked(start) || grid.isBlocked(goal)) return {};
+    const int startCell = grid.toId(start);
+    const int goalCell = grid.toId(goal);
+    if (reservations.isReserved(startCell, startTime)) return {};
+    const Heuristic h = { grid, heuristic, goalCell };
+    if (h.deadEnd(startCell) || !grid.isConnected(startCell, goalCell)) return {};
+
+    // After the last reserved timestep only the resting agents remain, and
+    // after the horizon nobody, so the search collapses those timesteps as in
+    // findPathWithConstraints. Times below are relative to 'startTime'.
+    int staticAfter = std::min(std::max(0, reservations.getMaxTimestep() - startTime + 1), horizon);
+    int earliestGoalTime;
+    const int earliestStay = reservations.getEarliestStayTime(goalCell);
+    if (earliestStay >= 0) {
+        earliestGoalTime = std::min(std::max(0, earliestStay - startTime), horizon);
+    }
+    else if (horizon < INT_MAX) {
+        // Someone else rests on the goal; it only counts until the horizon
+        staticAfter = horizon;
+        earliestGoalTime = horizon + 1;
+    }
+    else {
+        return {};  // Someone else rests on the goal for good
+    }
+    const GoalTimeBound f = { h, earliestGoalTime };
+
+    workspace.beginQuery(grid.getCellCount());
+    std::vector<SpaceTimeNode>& nodes = workspace.nodes;
+    StampedKeySet& closedSet = workspace.closedStates;
+    long long expanded = 0;
+    PROFILE_ONLY(LowLevelCall call(expanded, workspace, &nodes);)
+
+    nodes.push_back({ startCell, 0, -1 });
+    workspace.pushOpen({ f(startCell, 0), 0, 0 });
+
+    const int* offsets = grid.getNeighborOffsets();
+
+    while (!workspace.openEmpty()) {
+        int currentIndex = workspace.popOpen().node;
+        const SpaceTimeNode current = nodes[currentIndex];
+
+        int timeKey = std::min(current.g, staticAfter);
+        if (!closedSet.insert(stateKey(current.cell, timeKey))) continue;
+        if ((++expanded & 1023) == 0
+            && (isCancelled(control) || std::chrono::steady_clock::now() > deadline)) break;
+
+        if (current.cell == goalCell && current.g >= earliestGoalTime) {
+            Path path;
+            for (int i = currentIndex; i != -1; i = nodes[i].parent) {
+                path.push_back(grid.toPosition(nodes[i].cell));
+            }
+            std::reverse(path.begin(), path.end());
+            if (expandedCount) *expandedCount += expanded;
+            return path;
+        }
+
+        const int newG = current.g + 1;
+        for (int d = 0; d <= Grid::NUM_DIRECTIONS; ++d) {
+            bool isWait = d == Grid::NUM_DIRECTIONS;
+            if (isWait && current.g >= staticAfter) continue;
+
+            int neighbor = isWait ? current.cell : current.cell + offsets[d];
+            if (grid.isBlocked(neighbor) || h.deadEnd(neighbor)) continue;
+            if (newG <= horizon) {
+                if (reservations.isReserved(neighbor, startTime + newG)) continue;
+                if (!isWait && reservations.isMoveReserved(current.cell, neighbor, startTime + newG)) continue;
+            }
+            if (closedSet.contains(stateKey(neighbor, std::min(newG, staticAfter)))) continue;
+
+            nodes.push_back({ neighbor, newG, currentIndex });
+            workspace.pushOpen({ f(neighbor, newG), newG,
+                static_cast<int>(nodes.size()) - 1 });
+        }
+    }
+
+    if (expandedCount) *expandedCount += expanded;
+    return {};
+}
+
+namespace {
+    int focalBound(double suboptimality, int fmin) {
+        return static_cast<int>(std::floor(suboptimality * fmin + 1e-9));
+    }
+}
+
+Path findPathWithFocal(const Position& start, const Position& goal, int agent, const Grid& grid,
+    const ConstraintTable& constraints, const ConflictDetector& others, double suboptimality,
+    SearchWorkspace& workspace, const DistanceTable* heuristic, int* lowerBound, long long* expandedCount) {
+
+    if (grid.isBlocked(start) || grid.isBlocked(goal)) return {};
+    if (constraints.isVertexConstrained(start, 0)) return {};
+
+    const int startCell = grid.toId(start);
+    const int goalCell = grid.toId(goal);
+    const Heuristic h = { grid, heuristic, goalCell };
+    if (h.deadEnd(startCell) || !grid.isConnected(startCell, goalCell)) return {};
+    const bool constrained = !constraints.empty();
+
+    // Nothing changes after the last constraint and the last move of the other
+    // agents, so later timesteps collapse into one as in findPathWithConstraints
+    const int staticAfter = std::max(constraints.getMaxTimestep(), others.getLastTimestep()) + 1;
+    const int earliestGoalTime = constraints.getEarliestGoalTime(goal);
+    if (earliestGoalTime == INT_MAX) return {};  // A reserved agent rests on the goal for good
+    const GoalTimeBound lowerBoundOf = { h, earliestGoalTime };
+
+    workspace.beginQuery(grid.getCellCount());
+    std::vector<SpaceTimeNode>& nodes = workspace.nodes;
+    std::vector<int>& conflictCounts = workspace.nodeConflicts;
+    std::vector<uint8_t>& inOpen = workspace.nodeOpen;
+    StampedKeyMap& bestNode = workspace.bestNodes;        // Best node generated for each state
+    std::vector<OpenEntry>& open = workspace.focalOpen;   // For fmin
+    std::vector<OpenEntry>& waiting = workspace.focalWaiting;  // Open nodes with f > bound
+    std::vector<FocalEntry>& focal = workspace.focal;
+
+    int fmin = lowerBoundOf(startCell, 0);
+    int bound = focalBound(suboptimality, fmin);
+
+    // A state keeps only its best node: fewer timesteps, then fewer conflicts.
+    // Nodes are pushed to the focal list when they are within the bound and
+    // wait for the bound to reach them otherwise.
+    auto addNode = [&](int cell, int g, int parent, int conflicts) {
+        const uint64_t key = stateKey(cell, std::min(g, staticAfter));
+        if (const int* best = bestNode.find(key)) {
+            const int old = *best;
+            if (g > nodes[old].g || (g == nodes[old].g && conflicts >= conflictCounts[old])) return;
+            inOpen[old] = 0;
+        }
+        const int index = static_cast<int>(nodes.size());
+        nodes.push_back({ cell, g, parent });
+        conflictCounts.push_back(conflicts);
+        inOpen.push_back(1);
+        bestNode.set(key, index);
+
+        const int f = lowerBoundOf(cell, g);
+        open.push_back({ f, g, index });
+        std::push_heap(open.begin(), open.end(), OpenEntryCompare());
+        if (f <= bound) {
+            focal.push_back({ conflicts, f, g, index });
+            std::push_heap(focal.begin(), focal.end(), FocalEntryCompare());
+            PROFILE_ONLY(workspace.heapPushes++;)
+        }
+        else {
+            waiting.push_back({ f, g, index });
+            std::push_heap(waiting.begin(), waiting.end(), OpenEntryCompare());
+        }
+        };
+
+    const int* offsets = grid.getNeighborOffsets();
+    long long expanded = 0;
+    PROFILE_ONLY(LowLevelCall call(expanded, workspace, &nodes);)
+    addNode(startCell, 0, -1, 0);
+
+    while (true) {
+        // Entries of expanded or superseded nodes are dropped lazily
+        while (!open.empty() && !inOpen[open.front().node]) {
+            std::pop_heap(open.begin(), open.end(), OpenEntryCompare());
+            open.pop_back();
+        }
+        if (open.empty()) break;
+
+        // A higher fmin widens the focal list to the open nodes now within the bound
+        const int openMin = open.front().f;
+        if (openMin > fmin) {
+            const int newBound = focalBound(suboptimality, openMin);
+            while (!waiting.empty() && waiting.front().f <= newBound) {
+                const OpenEntry entry = waiting.front();
+                std::pop_heap(waiting.begin(), waiting.end(), OpenEntryCompare());
+                waiting.pop_back();
+                if (!inOpen[entry.node]) continue;
+                focal.push_back({ conflictCounts[entry.node], entry.f, entry.g, entry.node });
+                std::push_heap(focal.begin(), focal.end(), FocalEntryCompare());
+                PROFILE_ONLY(workspace.heapPushes++;)
+            }
+            fmin = openMin;
+            bound = newBound;
+        }
+
+        const FocalEntry top = focal.front();
+        std::pop_heap(focal.begin(), focal.end(), FocalEntryCompare());
+        focal.pop_back();
+        PROFILE_ONLY(workspace.heapPops++;)
+        if (!inOpen[top.node]) continue;
+        inOpen[top.node] = 0;
+        ++expanded;
+
+        const SpaceTimeNode current = nodes[top.node];
+        if (current.cell == goalCell && current.g >= earliestGoalTime) {
+            Path path;
+            for (int i = top.node; i != -1; i = nodes[i].parent) {
+                path.push_back(grid.toPosition(nodes[i].cell));
+            }
+            std::reverse(path.begin(), path.end());
+            if (lowerBound) *lowerBound = fmin;
+            if (expandedCount) *expandedCount += expanded;
+            return path;
+        }
+
+        const Position currentPos = grid.toPosition(current.cell);
+        const int newG = current.g + 1;
+        for (int d = 0; d <= Grid::NUM_DIRECTIONS; ++d) {
+            bool isWait = d == Grid::NUM_DIRECTIONS;
+            if (isWait && current.g >= staticAfter) continue;
+
+            int neighbor = isWait ? current.cell : current.cell + offsets[d];
+            if (grid.isBlocked(neighbor) || h.deadEnd(neighbor)) continue;
+
+            if (constrained) {
+                Position neighborPos = grid.toPosition(neighbor);
+                if (constraints.isVertexConstrained(neighborPos, newG) ||
+                    constraints.isEdgeConstrained(currentPos, neighborPos, newG)) {
+                    continue;
+                }
+            }
+            int conflicts = conflictCounts[top.node] + others.countMoveConflicts(agent, current.cell, neighbor, newG);
+            addNode(neighbor, newG, top.node, conflicts);
+        }
+    }
+
+    if (expandedCount) *expandedCount += expanded;
+    return {};
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "SearchWorkspace.h"
+#include "HeuristicCache.h"
+#include "ConflictDetector.h"
+#include "ReservationTable.h"
+#include "SearchControl.h"
+#include <unordered_set>
+#include <unordered_map>
+#include <cstdint>
+#include <climits>
+#include <chrono>
+
+struct Constraint {
+    enum Type { VERTEX, EDGE };
+
+    Type type;
+    int agent;
+    Position from;  // Only meaningful for EDGE constraints
+    Position to;    // The forbidden cell (VERTEX) or the target of the forbidden move (EDGE)
+    int timestep;   // Timestep at which the agent would be at 'to'
+};
+
+// Space-time constraints of a single agent, as collected along a CT branch.
+class ConstraintTable {
+public:
+    void add(const Constraint& constraint);
+    // Paths of agents outside the search that must be avoided as well, such as
+    // the agents LNS keeps fixed. Not owned; nullptr for none.
+    void setReservations(const ReservationTable* table) { reservations = table; }
+
+    bool isVertexConstrained(const Position& pos, int timestep) const;
+    bool isEdgeConstrained(const Position& from, const Position& to, int timestep) const;
+
+    // Largest timestep mentioned by any constraint or reservation. After it the map is static.
+    int getMaxTimestep() const;
+
+    // Earliest timestep at which the agent may stop at 'goal' for good;
+    // INT_MAX if a reserved agent rests there.
+    int getEarliestGoalTime(const Position& goal) const;
+
+    bool empty() const {
+        return vertexKeys.empty() && edgeKeys.empty() && (!reservations || reservations->empty());
+    }
+
+private:
+    std::unordered_set<uint64_t> vertexKeys;
+    std::unordered_set<uint64_t> edgeKeys;
+    std::unordered_map<Position, int> lastVertexTime;
+    int maxTimestep = -1;
+    const ReservationTable* reservations = nullptr;
+};
+
+// Spatial A* on the static grid (no waiting). Returns an empty path if the goal
+// is unreachable. 'heuristic' must be the distance table of 'goal'; without it
+// Manhattan distance is used.
+Path findShortestPath(const Position& start, const Position& goal, const Grid& grid,
+    SearchWorkspace& workspace, const DistanceTable* heuristic = nullptr, long long* expandedCount = nullptr);
+
+// Space-time A*: shortest path from start to goal that satisfies all constraints.
+// Waiting in place is allowed. Returns an empty path if none exists.
+Path findPathWithConstraints(const Position& start, const Position& goal, const Grid& grid,
+    const ConstraintTable& constraints, SearchWorkspace& workspace,
+    const DistanceTable* heuristic = nullptr, long long* expandedCount = nullptr);
+
+// Space-time A* against the paths of higher-priority agents: shortest path that
+// collides with none of the reservations, agents resting at their goals
+// included, and that can stay at its goal without being run into later.
+// The path leaves 'start' at timestep 'startTime' of the reservations. With a
+// 'horizon', collisions are only avoided during that many timesteps and the
+// rest of the path is the shortest one (rolling-horizon planning).
+// Returns an empty path if none exists, or once 'deadline' has passed or
+// 'control' is cancelled; a boxed-in agent can take a long search to rule out.
+Path findPathWithReservations(const Position& start, const Position& goal, const Grid& grid,
+    const ReservationTable& reservations, SearchWorkspace& workspace,
+    const DistanceTable* heuristic = nullptr, long long* expandedCount = nullptr,
+    int startTime = 0, int horizon = INT_MAX,
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(),
+    const SearchControl* control = nullptr);
+
+// Focal space-time search, the low level of ECBS. Among the open nodes with
+// f <= w * fmin it expands the one whose partial path collides least often with
+// the other agents' paths in 'others', so the path it returns costs at most
+// 'suboptimality' (w) times the shortest path under the constraints.
+// 'lowerBound' receives the fmin that bound the focal list when the path was
+// found, which is a lower bound on that shortest path.
+Path findPathWithFocal(const Position& start, const Position& goal, int agent, const Grid& grid,
+    const ConstraintTable& constraints, const ConflictDetector& others, double suboptimality,
+    SearchWorkspace& workspace, const DistanceTable* heuristic, int* lowerBound,
+    long long* expandedCount = nullptr);
@@ -0,0 +1,270 @@
+#include "MDD.h"
+#include "Profiling.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+    void sortUnique(std::vector<int>& cells) {
+        std::sort(cells.begin(), cells.end());
+        cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+    }
+
+    // Cells an agent following 'mdd' can move to from 'cell' at 'timestep'.
+    // After the MDD ends the agent stays at its goal. Returns the child count.
+    int collectChildren(const Grid& grid, const MDD& mdd, int timestep, int cell, int children[]) {
+        const int next = std::min(timestep + 1, mdd.cost);
+        const int* offsets = grid.getNeighborOffsets();
+        int count = 0;
+        if (mdd.contains(next, cell)) children[count++] = cell;
+        for (int dir = 0; dir < Grid::NUM_DIRECTIONS; ++dir) {
+            if (mdd.contains(next, cell + offsets[dir])) children[count++] = cell + offsets[dir];
+        }
+        return count;
+    }
+}
+
+bool MDD::contains(int timestep, int cell) const {
+    const std::vector<int>& level = levels[std::min(timestep, cost)];
+    return std::binary_search(level.begin(), level.end(), cell);
+}
+
+size_t MDD::nodeCount() const {
+    size_t count = 0;
+    for (const auto& level : levels) count += level.size();
+    return count;
+}
+
+MDD buildMDD(const Grid& grid, int startCell, const DistanceTable& goalDistances, int cost,
+    const MDDLimits& limits) {
+
+    PROFILE_PHASE(LOW_LEVEL_SEARCH);
+    MDD mdd;
+    if (!goalDistances.reachable(startCell) || goalDistances.at(startCell) > cost) return mdd;
+
+    // Every cell reached forwards is reachable in time, so keeping the cells that
+    // can still make it to the goal leaves exactly the MDD, without dead ends.
+    const int* offsets = grid.getNeighborOffsets();
+    mdd.cost = cost;
+    mdd.levels.resize(cost + 1);
+    mdd.levels[0].push_back(startCell);
+    size_t visited = 0;
+    for (int t = 1; t <= cost; ++t) {
+        std::vector<int>& level = mdd.levels[t];
+        for (int cell : mdd.levels[t - 1]) {
+            if ((++visited & 1023) == 0 && limits.exceeded()) return MDD();
+            if (goalDistances.at(cell) <= cost - t) level.push_back(cell);
+            for (int dir = 0; dir < Grid::NUM_DIRECTIONS; ++dir) {
+                int next = cell + offsets[dir];
+                if (!grid.isBlocked(next) && goalDistances.at(next) <= cost - t) level.push_back(next);
+            }
+        }
+        sortUnique(level);
+    }
+    return mdd;
+}
+
+MDD buildMDD(const Grid& grid, int startCell, const DistanceTable& goalDistances, int cost,
+    const ConstraintTable& constraints) {
+
+    PROFILE_PHASE(LOW_LEVEL_SEARCH);
+    if (constraints.empty()) return buildMDD(grid, startCell, goalDistances, cost);
+    MDD mdd;
+    const int goalCell = goalDistances.goalCell;
+    if (!goalDistances.reachable(startCell) || goalDistances.at(startCell) > cost
+        || constraints.getEarliestGoalTime(grid.toPosition(goalCell)) > cost) return mdd;
+
+    // A move into 'next' at timestep t, waits included
+    auto allowed = [&](int cell, int next, int t) {
+        const Position to = grid.toPosition(next);
+        if (constraints.isVertexConstrained(to, t)) return false;
+        return next == cell || !constraints.isEdgeConstrained(grid.toPosition(cell), to, t);
+        };
+
+    // Forwards as in the unconstrained MDD, but constraints can leave dead ends,
+    // so a backward pass keeps only the cells that still lead to the goal
+    const int* offsets = grid.getNeighborOffsets();
+    mdd.cost = cost;
+    mdd.levels.resize(cost + 1);
+    mdd.levels[0].push_back(startCell);
+    for (int t = 1; t <= cost; ++t) {
+        std::vector<int>& level = mdd.levels[t];
+        for (int cell : mdd.levels[t - 1]) {
+            if (goalDistances.at(cell) <= cost - t && allowed(cell, cell, t)) level.push_back(cell);
+            for (int dir = 0; dir < Grid::NUM_DIRECTIONS; ++dir) {
+                int next = cell + offsets[dir];
+                if (!grid.isBlocked(next) && goalDistances.at(next) <= cost - t && allowed(cell, next, t)) {
+                    level.push_back(next);
+                }
+            }
+        }
+        sortUnique(level);
+    }
+    if (mdd.levels[cost].empty()) return MDD();
+
+    for (int t = cost - 1; t >= 0; --t) {
+        const std::vector<int>& next = mdd.levels[t + 1];
+        auto leadsOn = [&](int cell) {
+            if (std::binary_search(next.begin(), next.end(), cell) && allowed(cell, cell, t + 1)) return true;
+            for (int dir = 0; dir < Grid::NUM_DIRECTIONS; ++dir) {
+                int child = cell + offsets[dir];
+                if (std::binary_search(next.begin(), next.end(), child) && allowed(cell, child, t + 1)) return true;
+            }
+            return false;
+            };
+        std::vector<int>& level = mdd.levels[t];
+        level.erase(std::remove_if(level.begin(), level.end(), [&](int cell) { return !leadsOn(cell); }), level.end());
+        if (level.empty()) return MDD();
+    }
+    return mdd;
+}
+
+MDD extendMDD(const Grid& grid, const MDD& previous, const DistanceTable& startDistances,
+    const DistanceTable& goalDistances, const MDDLimits& limits) {
+
+    PROFILE_PHASE(LOW_LEVEL_SEARCH);
+    // Level t of a cost-c MDD is {cell : start distance <= t, goal distance <= c - t}.
+    // For cost c + 1 that is old level t, old level t - 1, and the cells whose start
+    // distance is exactly t; those are only reached from frontier cells of level t - 1.
+    const int* offsets = grid.getNeighborOffsets();
+    const int cost = previous.cost + 1;
+    MDD mdd;
+    mdd.cost = cost;
+    mdd.levels.resize(cost + 1);
+    mdd.levels[0] = previous.levels[0];
+    size_t visited = 0;
+    for (int t = 1; t <= cost; ++t) {
+        std::vector<int>& level = mdd.levels[t];
+        if (t < cost) level = previous.levels[t];
+        level.insert(level.end(), previous.levels[t - 1].begin(), previous.levels[t - 1].end());
+        for (int cell : mdd.levels[t - 1]) {
+            if ((++visited & 1023) == 0 && limits.exceeded()) return MDD();
+            if (startDistances.at(cell) != t - 1) continue;
+            for (int dir = 0; dir < Grid::NUM_DIRECTIONS; ++dir) {
+                int next = cell + offsets[dir];
+                if (!grid.isBlocked(next) && goalDistances.at(next) <= cost - t) level.push_back(next);
+            }
+        }
+        sortUnique(level);
+    }
+    return mdd;
+}
+
+bool prunePair(const Grid& grid, MDD& a, MDD& b, const MDDLimits& limits, size_t maxStates) {
+    PROFILE_PHASE(CONFLICT_DETECTION);
+    typedef std::pair<int, int> PairState;
+    const int horizon = std::max(a.cost, b.cost);
+    const int startA = a.levels[0][0];
+    const int startB = b.levels[0][0];
+    if (startA == startB) return false;
+
+    // Forward: every joint state both agents can reach without colliding
+    std::vector<std::vector<PairState>> states(horizon + 1);
+    states[0].push_back({ startA, startB });
+    size_t total = 1, visited = 0;
+    int childrenA[Grid::NUM_DIRECTIONS + 1], childrenB[Grid::NUM_DIRECTIONS + 1];
+    for (int t = 0; t < horizon; ++t) {
+        std::vector<PairState>& next = states[t + 1];
+        for (const PairState& state : states[t]) {
+            if ((++visited & 1023) == 0 && limits.exceeded()) return false;
+            int countA = collectChildren(grid, a, t, state.first, childrenA);
+            int countB = collectChildren(grid, b, t, state.second, childrenB);
+            for (int i = 0; i < countA; ++i) {
+                for (int j = 0; j < countB; ++j) {
+                    if (childrenA[i] == childrenB[j]) continue;
+                    if (childrenA[i] == state.second && childrenB[j] == state.first) continue;
+                    next.push_back({ childrenA[i], childrenB[j] });
+                }
+            }
+        }
+        std::sort(next.begin(), next.end());
+        next.erase(std::unique(next.begin(), next.end()), next.end());
+        if (next.empty()) return false;
+        total += next.size();
+        if (total > maxStates) return true;
+    }
+
+    // Backward: keep the states from which both goals are reached. At the horizon
+    // both agents sit on their goals, so the single state there is alive.
+    std::vector<std::vector<char>> alive(horizon + 1);
+    alive[horizon].assign(states[horizon].size(), 1);
+    for (int t = horizon - 1; t >= 0; --t) {
+        const std::vector<PairState>& next = states[t + 1];
+        alive[t].assign(states[t].size(), 0);
+        for (size_t s = 0; s < states[t].size(); ++s) {
+            if ((++visited & 1023) == 0 && limits.exceeded()) return false;
+            const PairState& state = states[t][s];
+            int countA = collectChildren(grid, a, t, state.first, childrenA);
+            int countB = collectChildren(grid, b, t, state.second, childrenB);
+            for (int i = 0; i < countA && !alive[t][s]; ++i) {
+                for (int j = 0; j < countB; ++j) {
+                    if (childrenA[i] == childrenB[j]) continue;
+                    if (childrenA[i] == state.second && childrenB[j] == state.first) continue;
+                    auto it = std::lower_bound(next.begin(), next.end(), PairState(childrenA[i], childrenB[j]));
+                    if (alive[t + 1][it - next.begin()]) {
+                        alive[t][s] = 1;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    if (!alive[0][0]) return false;
+
+    for (int t = 0; t <= horizon; ++t) {
+        std::vector<int> cellsA, cellsB;
+        for (size_t s = 0; s < states[t].size(); ++s) {
+            if (!alive[t][s]) continue;
+            cellsA.push_back(states[t][s].first);
+            cellsB.push_back(states[t][s].second);
+        }
+        if (t <= a.cost) {
+            sortUnique(cellsA);
+            a.levels[t].swap(cellsA);
+        }
+        if (t <= b.cost) {
+            sortUnique(cellsB);
+            b.levels[t].swap(cellsB);
+        }
+    }
+    return true;
+}
+
+MDDCache::MDDCache(const Grid& grid, HeuristicCache& heuristics,
+    const std::vector<Position>& starts, const std::vector<Position>& goals)
+    : grid(grid), heuristics(heuristics), mdds(starts.size()), agentLocks(starts.size()), builds(0) {
+
+    for (size_t i = 0; i < starts.size(); ++i) {
+        startCells.push_back(grid.toId(starts[i]));
+        goalCells.push_back(grid.toId(goals[i]));
+        auto table = heuristics.get(goalCells[i]);
+        minimumCosts.push_back(table->reachable(startCells[i]) ? table->at(startCells[i]) : -1);
+    }
+}
+
+std::shared_ptr<const MDD> MDDCache::get(int agent, int cost, const MDDLimits& limits) {
+    const int minimumCost = minimumCosts[agent];
+    if (minimumCost < 0 || cost < minimumCost) return nullptr;
+
+    std::lock_guard<std::mutex> lock(agentLocks[agent]);
+    auto& byCost = mdds[agent];
+    const size_t index = static_cast<size_t>(cost - minimumCost);
+    if (index >= byCost.size()) {
+        auto goalDistances = heuristics.get(goalCells[agent]);
+        // Neither build is empty unless it was cut short, which is not cached
+        if (byCost.empty()) {
+            MDD mdd = buildMDD(grid, startCells[agent], *goalDistances, minimumCost, limits);
+            if (mdd.empty()) return nullptr;
+            byCost.push_back(std::make_shared<const MDD>(std::move(mdd)));
+            builds++;
+        }
+        // On an undirected grid the table of the start cell holds the start distances
+        auto startDistances = heuristics.get(startCells[agent]);
+        while (index >= byCost.size()) {
+            MDD mdd = extendMDD(grid, *byCost.back(), *startDistances, *goalDistances, limits);
+            if (mdd.empty()) return nullptr;
+            byCost.push_back(std::make_shared<const MDD>(std::move(mdd)));
+            builds++;
+        }
+    }
+    return byCost[index];
+}
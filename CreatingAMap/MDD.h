@@ -0,0 +1,87 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "HeuristicCache.h"
+#include "LowLevel.h"
+#include "SearchControl.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+// Multi-value decision diagram (Sharon et al. 2013): the set of every path of
+// one agent that reaches its goal at timestep 'cost' (waits included). Level t
+// holds the sorted ids of the cells the agent can occupy at timestep t on such a
+// path. Edges are implicit: the children of a cell are the cell itself and its
+// neighbours that appear on the next level. Every node has at least one child.
+struct MDD {
+    int cost = -1;
+    std::vector<std::vector<int>> levels;  // cost + 1 levels; the last one is {goal}
+
+    bool empty() const { return levels.empty(); }
+    bool contains(int timestep, int cell) const;
+    size_t nodeCount() const;
+};
+
+// When building or pruning MDDs gives up: past 'deadline', once 'stop' is
+// raised or when 'control' is cancelled. Polled every 1024 cells or states.
+struct MDDLimits {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    const std::atomic<bool>* stop = nullptr;
+    const SearchControl* control = nullptr;
+
+    bool exceeded() const {
+        return (stop && stop->load()) || isCancelled(control) || std::chrono::steady_clock::now() > deadline;
+    }
+};
+
+// MDD of cost 'cost', built forwards from the start. Empty if the goal cannot be
+// reached in that many steps, or if 'limits' are exceeded first.
+MDD buildMDD(const Grid& grid, int startCell, const DistanceTable& goalDistances, int cost,
+    const MDDLimits& limits = MDDLimits());
+
+// MDD of cost 'cost' that keeps only the paths satisfying 'constraints', as CBS
+// needs to classify conflicts. Empty if no such path exists.
+MDD buildMDD(const Grid& grid, int startCell, const DistanceTable& goalDistances, int cost,
+    const ConstraintTable& constraints);
+
+// MDD of cost 'previous.cost + 1' derived from 'previous'. Level t of the new
+// MDD is level t and t-1 of the old one plus the cells first reachable exactly at
+// t, so only the time frontier is expanded. 'startDistances' must be the distance
+// table of the start cell. Empty if 'limits' are exceeded.
+MDD extendMDD(const Grid& grid, const MDD& previous, const DistanceTable& startDistances,
+    const DistanceTable& goalDistances, const MDDLimits& limits = MDDLimits());
+
+// Removes from both MDDs the nodes that are not used by any pair of mutually
+// conflict-free paths. Returns false if no such pair exists. Gives up without
+// changing anything once the joint search exceeds 'maxStates' pair states, and
+// returns false without changing anything once 'limits' are exceeded.
+bool prunePair(const Grid& grid, MDD& a, MDD& b, const MDDLimits& limits = MDDLimits(),
+    size_t maxStates = 1u << 20);
+
+// MDDs of each agent by cost. Costs above the cheapest one are derived from the
+// previous cost with extendMDD and kept for reuse. Thread-safe; different agents
+// are built concurrently.
+class MDDCache {
+public:
+    MDDCache(const Grid& grid, HeuristicCache& heuristics,
+        const std::vector<Position>& starts, const std::vector<Position>& goals);
+
+    // Null if the agent cannot reach its goal in exactly 'cost' steps, or if
+    // 'limits' are exceeded while building the MDD; nothing is cached then.
+    std::shared_ptr<const MDD> get(int agent, int cost, const MDDLimits& limits = MDDLimits());
+
+    int getMinimumCost(int agent) const { return minimumCosts[agent]; }
+    long long getBuildCount() const { return builds.load(); }
+
+private:
+    const Grid& grid;
+    HeuristicCache& heuristics;
+    std::vector<int> startCells, goalCells;
+    std::vector<int> minimumCosts;  // -1 if unreachable
+    std::vector<std::vector<std::shared_ptr<const MDD>>> mdds;  // Per agent, indexed by cost - minimum cost
+    std::vector<std::mutex> agentLocks;
+    std::atomic<long long> builds;
+};
@@ -0,0 +1,296 @@
+#include "MapCache.h"
+#include "MovingAI.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstring>
+#include <random>
+#include <sstream>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    const char MAGIC[8] = { 'M', 'A', 'P', 'F', 'G', 'R', 'I', 'D' };
+
+    uint64_t alignUp(uint64_t offset) {
+        return (offset + 7) & ~static_cast<uint64_t>(7);
+    }
+
+    uint8_t tileClass(char c) {
+        switch (c) {
+        case '@': case 'O': return MapCache::OBSTACLE;
+        case 'T': return MapCache::TREE;
+        case 'W': return MapCache::WATER;
+        default: return MapCache::FREE;
+        }
+    }
+
+    const char TILE_CHARS[4] = { '.', '@', 'T', 'W' };
+
+    // Writes the values of table 'index' to 'out'; false to abandon the file
+    typedef std::function<bool(size_t index, std::ofstream& out)> TableWriter;
+
+    void padTo(std::ofstream& out, uint64_t offset) {
+        static const char zeros[8] = {};
+        uint64_t position = static_cast<uint64_t>(out.tellp());
+        if (offset > position) out.write(zeros, static_cast<std::streamsize>(offset - position));
+    }
+
+    bool writeCache(const std::string& path, const Grid& grid, const std::vector<char>& terrain,
+        uint64_t sourceSize, int64_t sourceTime, const std::vector<int>& tableGoals, const TableWriter& writeTable) {
+        const uint64_t cellCount = static_cast<uint64_t>(grid.getCellCount());
+        const uint64_t tileCount = static_cast<uint64_t>(grid.getWidth()) * grid.getHeight();
+
+        MapCache::Header header = {};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = MapCache::VERSION;
+        header.width = static_cast<uint32_t>(grid.getWidth());
+        header.height = static_cast<uint32_t>(grid.getHeight());
+        header.componentCount = static_cast<uint32_t>(grid.getComponentCount());
+        header.tableCount = static_cast<uint32_t>(tableGoals.size());
+        header.sourceSize = sourceSize;
+        header.sourceTime = sourceTime;
+        header.tilesOffset = alignUp(sizeof(MapCache::Header));
+        header.componentsOffset = alignUp(header.tilesOffset + (tileCount + 3) / 4);
+        header.tableGoalsOffset = alignUp(header.componentsOffset + cellCount * sizeof(int32_t));
+        header.tablesOffset = alignUp(header.tableGoalsOffset + tableGoals.size() * sizeof(int32_t));
+
+        std::vector<uint8_t> packed((tileCount + 3) / 4, 0);
+        for (uint64_t i = 0; i < tileCount; ++i) {
+            packed[i / 4] |= static_cast<uint8_t>(tileClass(terrain[i]) << (2 * (i % 4)));
+        }
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        padTo(out, header.tilesOffset);
+        out.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(packed.size()));
+        padTo(out, header.componentsOffset);
+        out.write(reinterpret_cast<const char*>(grid.getComponentLabels().data()),
+            static_cast<std::streamsize>(cellCount * sizeof(int32_t)));
+        padTo(out, header.tableGoalsOffset);
+        for (int goalCell : tableGoals) {
+            int32_t goal = goalCell;
+            out.write(reinterpret_cast<const char*>(&goal), sizeof(goal));
+        }
+        padTo(out, header.tablesOffset);
+        for (size_t t = 0; t < tableGoals.size(); ++t) {
+            if (!writeTable(t, out)) return false;
+        }
+        return static_cast<bool>(out.flush());
+    }
+
+    // Each writer gets its own temporary file (process id and a random
+    // suffix), so processes and threads rebuilding the same cache at once do
+    // not write into each other's file
+    std::string temporaryPathFor(const std::string& path) {
+#ifdef _WIN32
+        const int processId = _getpid();
+#else
+        const int processId = static_cast<int>(getpid());
+#endif
+        thread_local std::mt19937 random{ std::random_device()() };
+        std::ostringstream name;
+        name << path << '.' << processId << '.' << std::hex << random() << ".tmp";
+        return name.str();
+    }
+
+    // A cache is written to a temporary file first and then moved over the old
+    // one, so a reader never maps a half-written cache. The last writer wins.
+    bool commitCache(const std::string& temporaryPath, const std::string& path) {
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, path, error);
+        if (!error) return true;
+        std::filesystem::remove(temporaryPath, error);
+        std::cerr << "Cannot write map cache " << path << std::endl;
+        return false;
+    }
+
+    // Writes the cache for 'path' to a new temporary file and sets
+    // 'temporaryPath' to it. The file is removed again if writing fails.
+    bool writeTemporaryCache(const std::string& path, std::string& temporaryPath, const Grid& grid,
+        const std::vector<char>& terrain, uint64_t sourceSize, int64_t sourceTime,
+        const std::vector<int>& tableGoals, const TableWriter& writeTable) {
+        temporaryPath = temporaryPathFor(path);
+        if (writeCache(temporaryPath, grid, terrain, sourceSize, sourceTime, tableGoals, writeTable)) {
+            return true;
+        }
+        std::error_code error;
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+}
+
+MapCache::MapCache() : header(nullptr) {
+}
+
+void MapCache::close() {
+    file.reset();
+    header = nullptr;
+}
+
+bool MapCache::open(const std::string& mapFile) {
+    close();
+    this->mapFile = mapFile;
+
+    std::error_code error;
+    const uint64_t sourceSize = std::filesystem::file_size(mapFile, error);
+    if (error) {
+        std::cerr << "Cannot open map " << mapFile << std::endl;
+        return false;
+    }
+    const int64_t sourceTime = static_cast<int64_t>(
+        std::filesystem::last_write_time(mapFile, error).time_since_epoch().count());
+
+    const std::string cachePath = cachePathFor(mapFile);
+    if (mapCache(cachePath, sourceSize, sourceTime)) return true;
+    return rebuild(cachePath, sourceSize, sourceTime) && mapCache(cachePath, sourceSize, sourceTime);
+}
+
+bool MapCache::mapCache(const std::string& cachePath, uint64_t sourceSize, int64_t sourceTime) {
+    auto mapped = std::make_shared<MappedFile>();
+    if (!mapped->open(cachePath) || mapped->size() < sizeof(Header)) return false;
+
+    const Header* candidate = reinterpret_cast<const Header*>(mapped->data());
+    if (std::memcmp(candidate->magic, MAGIC, sizeof(MAGIC)) != 0 || candidate->version != VERSION
+        || candidate->sourceSize != sourceSize || candidate->sourceTime != sourceTime) {
+        return false;
+    }
+
+    // A truncated file is treated as stale
+    const uint64_t cellCount = static_cast<uint64_t>(candidate->width + 2) * (candidate->height + 2);
+    const uint64_t end = candidate->tablesOffset + candidate->tableCount * cellCount * sizeof(int32_t);
+    if (end > mapped->size()) return false;
+
+    file = std::move(mapped);
+    header = candidate;
+    return true;
+}
+
+bool MapCache::rebuild(const std::string& cachePath, uint64_t sourceSize, int64_t sourceTime) {
+    Grid grid;
+    std::vector<char> terrain;
+    if (!loadGridFile(mapFile, grid, &terrain)) return false;
+    auto noTables = [](size_t, std::ofstream&) { return true; };
+    std::string temporaryPath;
+    if (!writeTemporaryCache(cachePath, temporaryPath, grid, terrain, sourceSize, sourceTime, std::vector<int>(), noTables)) {
+        std::cerr << "Cannot write map cache " << cachePath << std::endl;
+        return false;
+    }
+    return commitCache(temporaryPath, cachePath);
+}
+
+int MapCache::getWidth() const {
+    return static_cast<int>(header->width);
+}
+
+int MapCache::getHeight() const {
+    return static_cast<int>(header->height);
+}
+
+int MapCache::getTableCount() const {
+    return static_cast<int>(header->tableCount);
+}
+
+void MapCache::loadGrid(Grid& grid, std::vector<char>* terrain) const {
+    const int width = getWidth();
+    const int height = getHeight();
+    const uint8_t* packed = reinterpret_cast<const uint8_t*>(file->data() + header->tilesOffset);
+
+    grid = Grid(width, height);
+    if (terrain) terrain->assign(static_cast<size_t>(width) * height, '.');
+    size_t i = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x, ++i) {
+            uint8_t tile = (packed[i / 4] >> (2 * (i % 4))) & 3;
+            if (tile != FREE) grid.setBlocked(x, y, true);
+            if (terrain) (*terrain)[i] = TILE_CHARS[tile];
+        }
+    }
+
+    const int32_t* labels = reinterpret_cast<const int32_t*>(file->data() + header->componentsOffset);
+    grid.setComponents(std::vector<int32_t>(labels, labels + grid.getCellCount()),
+        static_cast<int>(header->componentCount));
+}
+
+bool MapCache::hasTable(int goalCell) const {
+    const int32_t* goals = reinterpret_cast<const int32_t*>(file->data() + header->tableGoalsOffset);
+    return std::find(goals, goals + header->tableCount, goalCell) != goals + header->tableCount;
+}
+
+void MapCache::preloadTables(HeuristicCache& heuristics) const {
+    const size_t cellCount = static_cast<size_t>(header->width + 2) * (header->height + 2);
+    const int32_t* goals = reinterpret_cast<const int32_t*>(file->data() + header->tableGoalsOffset);
+    const int32_t* values = reinterpret_cast<const int32_t*>(file->data() + header->tablesOffset);
+    for (uint32_t t = 0; t < header->tableCount; ++t) {
+        auto table = std::make_shared<DistanceTable>();
+        table->goalCell = goals[t];
+        table->values = values + t * cellCount;
+        table->backing = file;
+        heuristics.insert(std::move(table));
+    }
+}
+
+bool MapCache::storeTables(const std::vector<int>& goalCells, HeuristicCache& heuristics,
+    const SearchControl* control) {
+    if (!isOpen()) return false;
+
+    Grid grid;
+    std::vector<char> terrain;
+    loadGrid(grid, &terrain);
+
+    const size_t cellCount = static_cast<size_t>(grid.getCellCount());
+    const int32_t* goals = reinterpret_cast<const int32_t*>(file->data() + header->tableGoalsOffset);
+    const int32_t* values = reinterpret_cast<const int32_t*>(file->data() + header->tablesOffset);
+    std::unordered_map<int, uint32_t> stored;
+    for (uint32_t t = 0; t < header->tableCount; ++t) stored[goals[t]] = t;
+
+    std::vector<int> tableGoals;
+    std::unordered_set<int> listed;
+    bool missing = false;
+    for (int goalCell : goalCells) {
+        if (grid.isBlocked(goalCell) || !listed.insert(goalCell).second) continue;
+        tableGoals.push_back(goalCell);
+        missing = missing || stored.find(goalCell) == stored.end();
+    }
+    if (!missing) return true;
+
+    // Stored tables are copied from the old mapping and missing ones are
+    // computed, one at a time, straight into the new file. Tables of goals
+    // that are not asked for are dropped, so the file does not grow with
+    // every agent set.
+    auto writeTable = [&](size_t index, std::ofstream& out) {
+        if (isCancelled(control)) return false;
+        auto it = stored.find(tableGoals[index]);
+        std::shared_ptr<const DistanceTable> computed;
+        const int32_t* table = it != stored.end() ? values + it->second * cellCount : nullptr;
+        if (!table) {
+            computed = heuristics.get(tableGoals[index]);
+            table = computed->values;
+        }
+        out.write(reinterpret_cast<const char*>(table), static_cast<std::streamsize>(cellCount * sizeof(int32_t)));
+        return static_cast<bool>(out);
+        };
+    const uint64_t sourceSize = header->sourceSize;
+    const int64_t sourceTime = header->sourceTime;
+    const std::string cachePath = cachePathFor(mapFile);
+    std::string temporaryPath;
+    if (!writeTemporaryCache(cachePath, temporaryPath, grid, terrain, sourceSize, sourceTime, tableGoals, writeTable)) {
+        if (!isCancelled(control)) std::cerr << "Cannot write map cache " << cachePath << std::endl;
+        return false;
+    }
+
+    // Windows cannot replace a mapped file; tables handed out earlier keep the
+    // old mapping alive
+    close();
+    bool written = commitCache(temporaryPath, cachePath);
+    return mapCache(cachePath, sourceSize, sourceTime) && written;
+}
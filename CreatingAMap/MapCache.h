@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Grid.h"
+#include "HeuristicCache.h"
+#include "MappedFile.h"
+#include "SearchControl.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// Compiled form of a map file, stored next to it as "<map file>.cache". The
+// versioned binary file holds the tiles packed two bits per cell, the
+// connected-component labels and, optionally, persisted distance tables. It is
+// memory-mapped read-only, so solver processes opening the same map share its
+// pages and start without parsing the text map. A cache that is missing, of
+// another version, or older than its source file is rebuilt on open. The
+// layout uses the byte order of the machine that wrote it.
+class MapCache {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    MapCache();
+
+    // Maps the cache of 'mapFile', rebuilding it first when needed.
+    bool open(const std::string& mapFile);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+
+    static std::string cachePathFor(const std::string& mapFile) { return mapFile + ".cache"; }
+
+    int getWidth() const;
+    int getHeight() const;
+
+    // Decodes the grid with its component labels; 'terrain' receives the tile
+    // characters row by row, as loadGridFile would.
+    void loadGrid(Grid& grid, std::vector<char>* terrain = nullptr) const;
+
+    int getTableCount() const;
+    bool hasTable(int goalCell) const;
+    // Hands every persisted table to 'heuristics'. The tables view the mapping.
+    void preloadTables(HeuristicCache& heuristics) const;
+    // Rewrites the cache to hold the tables of 'goalCells' unless all of them
+    // are stored already. Missing tables are computed through 'heuristics' and
+    // streamed to the file one at a time; tables of other goals are dropped.
+    // A cancelled 'control' leaves the old cache in place. Windows cannot
+    // replace a file that is still mapped, so store tables before handing
+    // mapped ones out with preloadTables().
+    bool storeTables(const std::vector<int>& goalCells, HeuristicCache& heuristics,
+        const SearchControl* control = nullptr);
+
+    // Per-cell tile classes in the packed tile array.
+    enum Tile : uint8_t { FREE = 0, OBSTACLE = 1, TREE = 2, WATER = 3 };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t width, height;
+        uint32_t componentCount;
+        uint32_t tableCount;
+        uint32_t reserved;
+        uint64_t sourceSize;
+        int64_t sourceTime;         // Modification time of the source map
+        uint64_t tilesOffset;       // 2 bits per cell, row-major
+        uint64_t componentsOffset;  // int32 per padded cell id
+        uint64_t tableGoalsOffset;  // int32 goal cell id per table
+        uint64_t tablesOffset;      // int32 per padded cell id, one block per table
+    };
+
+private:
+    bool mapCache(const std::string& cachePath, uint64_t sourceSize, int64_t sourceTime);
+    bool rebuild(const std::string& cachePath, uint64_t sourceSize, int64_t sourceTime);
+
+    std::string mapFile;
+    std::shared_ptr<MappedFile> file;  // Shared with the table views
+    const Header* header;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <vector>
+#include <tuple>
+#include <cstddef>
+
+struct Position {
+    int x, y;
+    bool operator==(const Position& other) const {
+        return x == other.x && y == other.y;
+    }
+    bool operator!=(const Position& other) const {
+        return !(*this == other);
+    }
+    bool operator<(const Position& other) const {
+        return std::tie(x, y) < std::tie(other.x, other.y);
+    }
+};
+
+namespace std {
+    template<>
+    struct hash<Position> {
+        size_t operator()(const Position& p) const {
+            return p.x * 1812433253 + p.y;
+        }
+    };
+}
+
+// A path lists the agent's cell at every timestep, path[0] being the start.
+// After its last entry the agent is assumed to wait at its goal forever.
+typedef std::vector<Position> Path;
+
+// Position of an agent at timestep t, taking the wait-at-goal rule into account.
+inline Position positionAt(const Path& path, size_t t) {
+    return t < path.size() ? path[t] : path.back();
+}
+
+struct SolverStats {
+    int highLevelExpanded = 0;      // CT nodes (CBS) expanded
+    int highLevelGenerated = 0;
+    long long lowLevelExpanded = 0; // summed over all low-level calls
+    int lowLevelCalls = 0;
+    double runtimeSeconds = 0.0;
+    int threads = 1;
+    double workerSeconds = 0.0;     // Busy time summed over all worker threads
+
+    // CBS improvements: the class of every conflict split on (when prioritizing)
+    // and how often each technique was applied
+    int cardinalConflicts = 0;
+    int semiCardinalConflicts = 0;
+    int nonCardinalConflicts = 0;
+    int bypasses = 0;
+    int rectangleSplits = 0;
+    int corridorSplits = 0;
+
+    // Independence detection: groups of agents solved jointly, and the size of the largest
+    int independentGroups = 0;
+    int largestGroup = 0;
+
+    // Anytime LNS: neighbourhoods replanned, and how many of them lowered the sum of costs
+    int neighborhoods = 0;
+    int improvements = 0;
+
+    // Parallel speedup estimate: how many workers were busy on average.
+    double speedup() const {
+        return runtimeSeconds > 0.0 ? workerSeconds / runtimeSeconds : 1.0;
+    }
+};
+
+// Solution quality of an anytime solver at one point in time.
+struct CostSample {
+    double seconds;
+    int sumOfCosts;
+};
+
+struct SolverResult {
+    bool solved = false;
+    std::vector<Path> paths;
+    int sumOfCosts = 0;
+    int makespan = 0;
+    int lowerBound = 0;  // Proven lower bound on the optimal sum of costs; sumOfCosts for optimal solvers
+    SolverStats stats;
+    std::vector<CostSample> costCurve;  // Anytime solvers: the sum of costs after every improvement
+    std::vector<int> unreachableAgents; // Why an instance failed without being searched; for the caller to report
+};
+
+// Cost of a single path: timesteps until the agent settles at its goal.
+inline int pathCost(const Path& path) {
+    return path.empty() ? 0 : static_cast<int>(path.size()) - 1;
+}
@@ -0,0 +1,104 @@
+#include "MappedFile.h"
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : bytes(nullptr), length(0), opened(false), mapped(false) {
+#ifdef _WIN32
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart == 0) {
+            CloseHandle(file);
+            opened = true;
+            return true;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view) {
+                fileHandle = file;
+                mappingHandle = mapping;
+                bytes = static_cast<const char*>(view);
+                length = static_cast<size_t>(fileSize.QuadPart);
+                opened = mapped = true;
+                return true;
+            }
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+    }
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat info;
+        if (fstat(fd, &info) == 0) {
+            if (info.st_size == 0) {
+                ::close(fd);
+                opened = true;
+                return true;
+            }
+            void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);  // The mapping stays valid without the descriptor
+            if (view != MAP_FAILED) {
+                bytes = static_cast<const char*>(view);
+                length = static_cast<size_t>(info.st_size);
+                opened = mapped = true;
+                return true;
+            }
+        }
+        else {
+            ::close(fd);
+        }
+    }
+#endif
+
+    // Fallback: read the whole file
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) return false;
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    bytes = buffer.empty() ? nullptr : buffer.data();
+    length = buffer.size();
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapped) {
+#ifdef _WIN32
+        UnmapViewOfFile(bytes);
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+        CloseHandle(static_cast<HANDLE>(fileHandle));
+        fileHandle = mappingHandle = nullptr;
+#else
+        munmap(const_cast<char*>(bytes), length);
+#endif
+    }
+    std::vector<char>().swap(buffer);
+    bytes = nullptr;
+    length = 0;
+    opened = mapped = false;
+}
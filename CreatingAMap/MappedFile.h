@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Read-only view of a whole file. The file is memory-mapped, so pages are only
+// read when touched and are shared between processes; if mapping is not
+// possible the contents are read into memory instead.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes;
+    size_t length;
+    bool opened;              // An empty file has no data but is open
+    bool mapped;
+    std::vector<char> buffer; // Fallback copy when mapping failed
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
@@ -0,0 +1,207 @@
+#include "MovingAI.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace {
+    bool isBlockedTile(char c) {
+        return c == '@' || c == 'O' || c == 'T' || c == 'W';
+    }
+
+    // Forward-only reader over a buffer that is not null-terminated.
+    struct Cursor {
+        const char* pos;
+        const char* end;
+
+        bool atEnd() const { return pos >= end; }
+
+        // Next line without its terminator ("\n" or "\r\n").
+        void nextLine(const char*& lineBegin, const char*& lineEnd) {
+            lineBegin = pos;
+            const char* newline = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+            lineEnd = newline ? newline : end;
+            pos = newline ? newline + 1 : end;
+            if (lineEnd > lineBegin && lineEnd[-1] == '\r') --lineEnd;
+        }
+
+        void skipBlanks() {
+            while (pos < end && (*pos == ' ' || *pos == '\t')) ++pos;
+        }
+
+        bool readWord(std::string& word) {
+            skipBlanks();
+            const char* begin = pos;
+            while (pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '\n') ++pos;
+            word.assign(begin, pos);
+            return pos > begin;
+        }
+
+        template <typename T>
+        bool readNumber(T& value) {
+            skipBlanks();
+            auto parsed = std::from_chars(pos, end, value);
+            if (parsed.ec != std::errc()) return false;
+            pos = parsed.ptr;
+            return true;
+        }
+    };
+
+    bool startsWith(const char* begin, const char* end, const char* prefix) {
+        size_t length = std::strlen(prefix);
+        return static_cast<size_t>(end - begin) >= length && std::memcmp(begin, prefix, length) == 0;
+    }
+
+    void fillRow(Grid& grid, std::vector<char>* terrain, int y, const char* begin, const char* end) {
+        const int length = std::min(grid.getWidth(), static_cast<int>(end - begin));
+        for (int x = 0; x < length; ++x) {
+            if (isBlockedTile(begin[x])) grid.setBlocked(x, y, true);
+        }
+        if (terrain) std::copy(begin, begin + length, terrain->begin() + static_cast<size_t>(y) * grid.getWidth());
+    }
+}
+
+bool parseGrid(const char* data, size_t size, Grid& grid, std::vector<char>* terrain) {
+    Cursor cursor = { data, data + size };
+    const char* lineBegin = data;
+    const char* lineEnd = data;
+
+    // Find out whether the file has a MovingAI header
+    Cursor probe = cursor;
+    while (!probe.atEnd()) {
+        probe.nextLine(lineBegin, lineEnd);
+        if (lineBegin != lineEnd) break;
+    }
+    const bool hasHeader = lineBegin != lineEnd && startsWith(lineBegin, lineEnd, "type");
+
+    if (hasHeader) {
+        int width = 0, height = 0;
+        while (!cursor.atEnd()) {
+            cursor.nextLine(lineBegin, lineEnd);
+            Cursor field = { lineBegin, lineEnd };
+            std::string key;
+            field.readWord(key);
+            if (key == "height") field.readNumber(height);
+            else if (key == "width") field.readNumber(width);
+            else if (key == "map") break;
+        }
+        if (width <= 0 || height <= 0) return false;
+
+        grid = Grid(width, height);
+        if (terrain) terrain->assign(static_cast<size_t>(width) * height, '.');
+        for (int y = 0; y < height && !cursor.atEnd(); ++y) {
+            cursor.nextLine(lineBegin, lineEnd);
+            fillRow(grid, terrain, y, lineBegin, lineEnd);
+        }
+        grid.computeComponents();
+        return true;
+    }
+
+    // No header: the rows decide the size, so remember where they are
+    std::vector<std::pair<const char*, const char*>> rows;
+    int width = 0;
+    while (!cursor.atEnd()) {
+        cursor.nextLine(lineBegin, lineEnd);
+        rows.push_back({ lineBegin, lineEnd });
+        width = std::max(width, static_cast<int>(lineEnd - lineBegin));
+    }
+    while (!rows.empty() && rows.back().first == rows.back().second) rows.pop_back();
+    if (width <= 0 || rows.empty()) return false;
+
+    grid = Grid(width, static_cast<int>(rows.size()));
+    if (terrain) terrain->assign(static_cast<size_t>(width) * rows.size(), '.');
+    for (size_t y = 0; y < rows.size(); ++y) {
+        fillRow(grid, terrain, static_cast<int>(y), rows[y].first, rows[y].second);
+    }
+    grid.computeComponents();
+    return true;
+}
+
+bool loadGridFile(const std::string& filename, Grid& grid, std::vector<char>* terrain) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        std::cerr << "Cannot open map " << filename << std::endl;
+        return false;
+    }
+    if (!parseGrid(file.data(), file.size(), grid, terrain)) {
+        std::cerr << "Map " << filename << " has no cells" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ScenarioFile::open(const std::string& filename) {
+    this->filename = filename;
+    mapName.clear();
+    lineStarts.clear();
+    if (!file.open(filename)) {
+        std::cerr << "Cannot open scenario " << filename << std::endl;
+        return false;
+    }
+
+    Cursor cursor = { file.data(), file.data() + file.size() };
+    const char* lineBegin;
+    const char* lineEnd;
+    while (!cursor.atEnd()) {
+        cursor.nextLine(lineBegin, lineEnd);
+        if (lineBegin == lineEnd || startsWith(lineBegin, lineEnd, "version")) continue;
+        lineStarts.push_back(static_cast<size_t>(lineBegin - file.data()));
+    }
+
+    if (!lineStarts.empty()) {
+        Cursor first = { file.data() + lineStarts[0], file.data() + file.size() };
+        int bucket;
+        if (!first.readNumber(bucket) || !first.readWord(mapName)) {
+            std::cerr << "Malformed scenario file " << filename << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ScenarioFile::getEntry(size_t index, ScenarioEntry& entry) const {
+    if (index >= size()) {
+        std::cerr << "No entry " << index + 1 << " in scenario " << filename << std::endl;
+        return false;
+    }
+    const char* begin = file.data() + lineStarts[index];
+    const char* end = file.data() + file.size();
+    const char* newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+    Cursor cursor = { begin, newline ? newline : end };
+
+    std::string name;
+    if (!cursor.readNumber(entry.bucket) || !cursor.readWord(name)
+        || !cursor.readNumber(entry.mapWidth) || !cursor.readNumber(entry.mapHeight)
+        || !cursor.readNumber(entry.start.x) || !cursor.readNumber(entry.start.y)
+        || !cursor.readNumber(entry.goal.x) || !cursor.readNumber(entry.goal.y)
+        || !cursor.readNumber(entry.optimalLength)) {
+        std::cerr << "Malformed line " << index + 1 << " in scenario " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ScenarioFile::getEntries(size_t count, std::vector<ScenarioEntry>& entries) const {
+    entries.resize(std::min(count, size()));
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (!getEntry(i, entries[i])) return false;
+    }
+    return true;
+}
+
+bool writeScenarioFile(const std::string& filename, const std::string& mapName, const std::vector<ScenarioEntry>& entries) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Cannot write scenario " << filename << std::endl;
+        return false;
+    }
+    file << "version 1\n" << std::setprecision(10);
+    for (const auto& entry : entries) {
+        file << entry.bucket << '\t' << mapName << '\t' << entry.mapWidth << '\t' << entry.mapHeight << '\t'
+            << entry.start.x << '\t' << entry.start.y << '\t' << entry.goal.x << '\t' << entry.goal.y << '\t'
+            << entry.optimalLength << '\n';
+    }
+    return static_cast<bool>(file);
+}
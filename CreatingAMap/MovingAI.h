@@ -0,0 +1,52 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+
+// One line of a MovingAI scenario file: a start/goal pair on the named map.
+struct ScenarioEntry {
+    int bucket;
+    int mapWidth, mapHeight;
+    Position start, goal;
+    double optimalLength;  // Octile length reported by the benchmark
+};
+
+// Loads a map in the MovingAI format ("type/height/width/map" header); the size
+// comes from the header. Files without a header, like the bundled map*.txt, are
+// read as plain rows, one row per line (blank lines included, as the saved agent
+// positions expect), and sized from the rows. '@', 'O', 'T' and 'W' are blocked.
+// The file is memory-mapped and parsed in one pass. 'terrain', if given,
+// receives the raw tile characters row by row ('.' where a row is short).
+// The grid comes with its connected components labelled.
+bool loadGridFile(const std::string& filename, Grid& grid, std::vector<char>* terrain = nullptr);
+
+// Same as loadGridFile for a map that is already in memory.
+bool parseGrid(const char* data, size_t size, Grid& grid, std::vector<char>* terrain = nullptr);
+
+// A MovingAI .scen file (version 1). Opening it maps the file and only records
+// where each entry line starts; entries are parsed when they are asked for, so
+// files with thousands of lines open instantly.
+class ScenarioFile {
+public:
+    bool open(const std::string& filename);
+
+    const std::string& getMapName() const { return mapName; }
+    size_t size() const { return lineStarts.size(); }
+
+    // False if the line is malformed or there is no entry 'index'.
+    bool getEntry(size_t index, ScenarioEntry& entry) const;
+    // Parses the first 'count' entries (fewer if the file is shorter).
+    bool getEntries(size_t count, std::vector<ScenarioEntry>& entries) const;
+
+private:
+    MappedFile file;
+    std::string filename;
+    std::string mapName;  // As written in the first entry
+    std::vector<size_t> lineStarts;
+};
+
+// Writes 'entries' as a MovingAI .scen file (version 1) for the map 'mapName'.
+bool writeScenarioFile(const std::string& filename, const std::string& mapName, const std::vector<ScenarioEntry>& entries);
@@ -0,0 +1,239 @@
+#include "PBS.h"
+#include "LowLevel.h"
+#include "ReservationTable.h"
+#include "ConflictDetector.h"
+#include "Profiling.h"
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <tuple>
+
+namespace {
+    // A node of the priority tree. 'higher[i]' lists the agents that were given
+    // priority over agent i directly; priorities are transitive.
+    struct PBSNode {
+        std::vector<Path> paths;
+        std::vector<std::vector<int>> higher;
+        int cost;
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    int sumOfCosts(const std::vector<Path>& paths) {
+        int total = 0;
+        for (const auto& path : paths) total += pathCost(path);
+        return total;
+    }
+
+    // The earliest conflict, ties broken by agent ids, as in CBS.
+    const Conflict& selectConflict(const std::vector<Conflict>& conflicts) {
+        auto key = [](const Conflict& c) {
+            return std::make_tuple(c.timestep, std::min(c.agent1, c.agent2), std::max(c.agent1, c.agent2));
+            };
+        const Conflict* best = &conflicts.front();
+        for (const Conflict& conflict : conflicts) {
+            if (key(conflict) < key(*best)) best = &conflict;
+        }
+        return *best;
+    }
+
+    // Marks every agent with priority over 'agent', directly or transitively.
+    void collectHigher(const PBSNode& node, int agent, std::vector<char>& marked) {
+        std::vector<int> stack(node.higher[agent]);
+        while (!stack.empty()) {
+            int other = stack.back();
+            stack.pop_back();
+            if (marked[other]) continue;
+            marked[other] = 1;
+            stack.insert(stack.end(), node.higher[other].begin(), node.higher[other].end());
+        }
+    }
+
+    // Whether two agents collide, either moving or resting at their goals.
+    bool pathsCollide(const Path& a, const Path& b) {
+        PROFILE_PHASE(CONFLICT_DETECTION);
+        const size_t horizon = std::max(a.size(), b.size());
+        for (size_t t = 0; t < horizon; ++t) {
+            if (positionAt(a, t) == positionAt(b, t)) return true;
+            if (t > 0 && positionAt(a, t) == positionAt(b, t - 1) && positionAt(a, t - 1) == positionAt(b, t)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    struct PBSProblem {
+        const std::vector<Position>& starts;
+        const std::vector<Position>& goals;
+        const Grid& grid;
+        HeuristicCache& heuristics;
+        Clock::time_point deadline;
+        const SearchControl* control;
+    };
+
+    // Replans 'agent' and, in topological order, every agent below it that now
+    // collides with one of its higher-priority agents. False if one of them has
+    // no path any more, time ran out or the search was cancelled.
+    bool replanBelow(const PBSProblem& problem, PBSNode& node, int agent, SearchWorkspace& workspace,
+        ReservationTable& reservations, SolverStats& stats) {
+
+        const int numAgents = static_cast<int>(node.paths.size());
+        std::vector<std::vector<int>> lower(numAgents);
+        for (int i = 0; i < numAgents; ++i) {
+            for (int h : node.higher[i]) lower[h].push_back(i);
+        }
+
+        // 'agent' and everything below it
+        std::vector<char> affected(numAgents, 0);
+        std::vector<int> stack(1, agent);
+        while (!stack.empty()) {
+            int current = stack.back();
+            stack.pop_back();
+            if (affected[current]) continue;
+            affected[current] = 1;
+            stack.insert(stack.end(), lower[current].begin(), lower[current].end());
+        }
+
+        // Kahn's algorithm restricted to the affected agents
+        std::vector<int> pendingHigher(numAgents, 0);
+        for (int i = 0; i < numAgents; ++i) {
+            if (!affected[i]) continue;
+            for (int h : node.higher[i]) {
+                if (affected[h]) pendingHigher[i]++;
+            }
+        }
+        std::vector<int> ready(1, agent);
+        std::vector<char> marked(numAgents);
+        while (!ready.empty()) {
+            const int current = ready.back();
+            ready.pop_back();
+            for (int l : lower[current]) {
+                if (affected[l] && --pendingHigher[l] == 0) ready.push_back(l);
+            }
+
+            std::fill(marked.begin(), marked.end(), 0);
+            collectHigher(node, current, marked);
+            bool replan = current == agent;
+            for (int other = 0; other < numAgents && !replan; ++other) {
+                replan = marked[other] && pathsCollide(node.paths[current], node.paths[other]);
+            }
+            if (!replan) continue;
+            if (Clock::now() > problem.deadline || isCancelled(problem.control)) return false;
+
+            reservations.clear();
+            for (int other = 0; other < numAgents; ++other) {
+                if (marked[other]) reservations.reservePath(node.paths[other]);
+            }
+            node.paths[current] = findPathWithReservations(problem.starts[current], problem.goals[current],
+                problem.grid, reservations, workspace, problem.heuristics.get(problem.goals[current]).get(),
+                &stats.lowLevelExpanded, 0, INT_MAX, problem.deadline, problem.control);
+            stats.lowLevelCalls++;
+            if (node.paths[current].empty()) return false;
+        }
+        return true;
+    }
+}
+
+SolverResult solvePBS(const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid, const PBSOptions& options) {
+
+    PROFILE_PHASE(HIGH_LEVEL);
+    auto startTime = Clock::now();
+    SolverResult result;
+    const int numAgents = static_cast<int>(starts.size());
+
+    std::unique_ptr<HeuristicCache> privateCache;
+    HeuristicCache* heuristics = options.heuristics;
+    if (!heuristics) {
+        privateCache.reset(new HeuristicCache(grid));
+        heuristics = privateCache.get();
+    }
+    const auto deadline = startTime + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.timeLimitSeconds));
+    PBSProblem problem = { starts, goals, grid, *heuristics, deadline, options.control };
+
+    SearchWorkspace workspace;
+    ReservationTable reservations(grid);
+    std::unique_ptr<PBSNode> root(new PBSNode());
+    root->paths.resize(numAgents);
+    root->higher.resize(numAgents);
+    for (int i = 0; i < numAgents; ++i) {
+        root->paths[i] = findPathWithReservations(starts[i], goals[i], grid, reservations, workspace,
+            heuristics->get(goals[i]).get(), &result.stats.lowLevelExpanded, 0, INT_MAX, deadline, options.control);
+        result.stats.lowLevelCalls++;
+        if (root->paths[i].empty() || isCancelled(options.control) || Clock::now() > deadline) {
+            result.stats.runtimeSeconds = secondsSince(startTime);
+            return result;  // Some agent cannot reach its goal at all, time ran out or the caller gave up
+        }
+    }
+    root->cost = sumOfCosts(root->paths);
+    result.lowerBound = root->cost;
+    result.stats.highLevelGenerated = 1;
+
+    // Depth-first: the stack holds the unexplored children of the current branch
+    ConflictDetector detector(grid);
+    std::vector<std::unique_ptr<PBSNode>> stack;
+    stack.push_back(std::move(root));
+    std::vector<Conflict> conflicts;
+    std::vector<char> marked(numAgents);
+    while (!stack.empty() && result.stats.highLevelExpanded < options.maxNodes
+        && secondsSince(startTime) <= options.timeLimitSeconds && !isCancelled(options.control)) {
+
+        std::unique_ptr<PBSNode> node = std::move(stack.back());
+        stack.pop_back();
+        detector.syncPaths(node->paths);
+        conflicts.clear();
+        detector.findAllConflicts(conflicts);
+        if (conflicts.empty()) {
+            result.solved = true;
+            result.paths = std::move(node->paths);
+            break;
+        }
+        result.stats.highLevelExpanded++;
+        publishProgress(options.control, result.stats.highLevelExpanded, node->cost,
+            static_cast<int>(conflicts.size()));
+
+        const Conflict& conflict = selectConflict(conflicts);
+        std::unique_ptr<PBSNode> children[2];
+        const int agents[2] = { conflict.agent1, conflict.agent2 };
+        for (int i = 0; i < 2; ++i) {
+            const int first = agents[i];
+            const int second = agents[1 - i];
+
+            // Letting 'first' go first must not contradict the priorities so far
+            std::fill(marked.begin(), marked.end(), 0);
+            collectHigher(*node, first, marked);
+            if (marked[second]) continue;
+
+            std::unique_ptr<PBSNode> child(new PBSNode(*node));
+            std::fill(marked.begin(), marked.end(), 0);
+            collectHigher(*node, second, marked);
+            if (!marked[first]) child->higher[second].push_back(first);
+            if (!replanBelow(problem, *child, second, workspace, reservations, result.stats)) continue;
+            child->cost = sumOfCosts(child->paths);
+            children[i] = std::move(child);
+        }
+
+        // The cheaper child goes on top of the stack
+        if (children[0] && children[1] && children[0]->cost < children[1]->cost) std::swap(children[0], children[1]);
+        for (auto& child : children) {
+            if (!child) continue;
+            stack.push_back(std::move(child));
+            result.stats.highLevelGenerated++;
+        }
+    }
+
+    if (result.solved) {
+        result.sumOfCosts = sumOfCosts(result.paths);
+        for (const auto& path : result.paths) {
+            result.makespan = std::max(result.makespan, pathCost(path));
+        }
+    }
+    result.stats.runtimeSeconds = secondsSince(startTime);
+    result.stats.workerSeconds = result.stats.runtimeSeconds;
+    return result;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "HeuristicCache.h"
+#include "SearchControl.h"
+
+struct PBSOptions {
+    int maxNodes = 10000;           // Priority tree node expansion limit
+    double timeLimitSeconds = 60.0;
+    HeuristicCache* heuristics = nullptr;  // Shared distance tables; a private cache is used if null
+    SearchControl* control = nullptr;      // Progress and cancellation, optional
+};
+
+// Priority-Based Search (Ma et al. 2019). Instead of fixing a total order up
+// front, a depth-first search over partial priority orderings adds one pairwise
+// priority per conflict: each child lets one agent of the conflict go first and
+// replans the other one, together with every agent below it that now collides
+// with an agent above, against the reservations of all agents above it. The
+// cheaper child is explored first and the first conflict-free node is returned.
+// Incomplete and suboptimal, but it scales far beyond CBS. The result's
+// lowerBound is the sum of the agents' shortest path lengths.
+SolverResult solvePBS(const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid, const PBSOptions& options = PBSOptions());
@@ -0,0 +1,102 @@
+#include "PlanExecutor.h"
+#include <algorithm>
+
+PlanExecutor::PlanExecutor(const Grid& grid, AgentTable& agents) : grid(grid), agents(agents), finished(false) {
+    reset();
+}
+
+void PlanExecutor::reset() {
+    agents.rewind();
+    metrics = ExecutionMetrics();
+    occupant.assign(grid.getCellCount(), -1);
+    fromCell.assign(agents.size(), -1);
+    displaced.assign(agents.size(), -1);
+    for (int i = 0; i < agents.size(); ++i) {
+        if (grid.inBounds(agents.getPosition(i))) occupy(i, grid.toId(agents.getPosition(i)));
+        if (agents.hasArrived(i)) metrics.arrivedAgents++;
+    }
+    finished = allArrived();
+}
+
+void PlanExecutor::occupy(int agent, int cell) {
+    if (occupant[cell] >= 0 && occupant[cell] != agent) metrics.vertexCollisions++;
+    else occupant[cell] = agent;
+}
+
+void PlanExecutor::checkPlan(int agent) {
+    const int length = agents.getPathLength(agent);
+    if (length == 0) return;  // Nothing planned to compare with
+    const Position planned = agents.getPath(agent)[std::min(metrics.timesteps, length - 1)];
+    if (agents.getPosition(agent) != planned) metrics.deviations++;
+}
+
+void PlanExecutor::step() {
+    if (finished) return;
+
+    // Who moves; agents without steps left and agents blocked by stopped ones wait
+    movers.clear();
+    int waits = 0, blocked = 0;
+    const int numAgents = agents.size();
+    for (int i = 0; i < numAgents; ++i) {
+        fromCell[i] = -1;
+        if (agents.hasArrived(i)) continue;
+        if (!agents.hasNextStep(i) || !grid.inBounds(agents.getNextStep(i))) {
+            waits++;
+            continue;
+        }
+        const int nextCell = grid.toId(agents.getNextStep(i));
+        const int other = occupant[nextCell];
+        if (other >= 0 && other != i && agents.hasArrived(other)) {
+            blocked++;
+            waits++;
+            continue;
+        }
+        fromCell[i] = grid.inBounds(agents.getPosition(i)) ? grid.toId(agents.getPosition(i)) : -1;
+        displaced[i] = other == i ? -1 : other;
+        movers.push_back(i);
+    }
+    // Nobody can move now, and as stopped agents stay put, nobody ever will
+    if (movers.empty()) {
+        metrics.blockedMoves += blocked;
+        finished = true;
+        return;
+    }
+
+    const int t = ++metrics.timesteps;
+    metrics.waits += waits;
+    metrics.blockedMoves += blocked;
+
+    // All movers leave their cells first, so agents following each other do not collide
+    for (int agent : movers) {
+        if (fromCell[agent] >= 0 && occupant[fromCell[agent]] == agent) occupant[fromCell[agent]] = -1;
+    }
+    for (int agent : movers) {
+        agents.advance(agent);
+        const int cell = grid.toId(agents.getPosition(agent));
+        if (cell == fromCell[agent]) metrics.waits++;
+        occupy(agent, cell);
+        if (agents.hasArrived(agent)) {
+            metrics.arrivedAgents++;
+            metrics.sumOfCosts += t;
+        }
+    }
+    // Two agents that swapped cells, counted once
+    for (int agent : movers) {
+        const int other = displaced[agent];
+        if (other > agent && fromCell[other] >= 0 && fromCell[other] == grid.toId(agents.getPosition(agent))
+            && grid.toId(agents.getPosition(other)) == fromCell[agent]) {
+            metrics.edgeCollisions++;
+        }
+    }
+    for (int i = 0; i < numAgents; ++i) {
+        checkPlan(i);
+    }
+    finished = allArrived();
+}
+
+bool PlanExecutor::run(int maxSteps) {
+    for (int i = 0; i < maxSteps && !finished; ++i) {
+        step();
+    }
+    return allArrived();
+}
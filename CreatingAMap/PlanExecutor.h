@@ -0,0 +1,63 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "AgentTable.h"
+#include <vector>
+#include <climits>
+
+// What an execution did, in timesteps.
+struct ExecutionMetrics {
+    int timesteps = 0;        // Executed so far; the makespan once every agent has arrived
+    int arrivedAgents = 0;
+    int sumOfCosts = 0;       // Arrival timesteps of the agents that have arrived
+    int waits = 0;            // Timesteps agents stood still before arriving, planned or not
+    int blockedMoves = 0;     // Moves held back because a stopped agent was in the way
+    int deviations = 0;       // Agent-timesteps spent away from the planned position
+    int vertexCollisions = 0;
+    int edgeCollisions = 0;
+
+    // Every agent arrived exactly as planned.
+    bool matchesPlan(int numAgents) const {
+        return arrivedAgents == numAgents && deviations == 0 && vertexCollisions == 0 && edgeCollisions == 0;
+    }
+};
+
+// Executes the agents' planned paths in discrete timesteps, independently of
+// any rendering: step() moves all agents by one timestep and the caller
+// decides how often to call it, from a frame timer or through run() as fast
+// as possible. An agent follows its path and stops for good on its goal once
+// the path is used up; a move into a stopped agent's cell is held back.
+// Occupancy is one array over the grid's cells, so a step costs O(agents).
+// Every step checks the executed positions against the plan and against each
+// other.
+class PlanExecutor {
+public:
+    // Rewinds 'agents', which must outlive the executor.
+    PlanExecutor(const Grid& grid, AgentTable& agents);
+
+    void reset();
+    void step();
+    // Steps until finished or for 'maxSteps'; true if every agent arrived.
+    bool run(int maxSteps = INT_MAX);
+
+    // Every agent arrived, or the last step changed nothing and none ever will.
+    bool isFinished() const { return finished; }
+    bool allArrived() const { return metrics.arrivedAgents == agents.size(); }
+    const ExecutionMetrics& getMetrics() const { return metrics; }
+
+private:
+    void occupy(int agent, int cell);
+    void checkPlan(int agent);
+
+    const Grid& grid;
+    AgentTable& agents;
+    ExecutionMetrics metrics;
+    bool finished;
+
+    std::vector<int> occupant;  // Agent on each cell id, -1 for none
+    // Per step: the agents that move, where from, and who stood on their next cell
+    std::vector<int> movers;
+    std::vector<int> fromCell;
+    std::vector<int> displaced;
+};
@@ -0,0 +1,94 @@
+#include "PrioritizedPlanning.h"
+#include "LowLevel.h"
+#include "Profiling.h"
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <climits>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+bool planInOrder(const std::vector<int>& order, const std::vector<Position>& starts,
+    const std::vector<Position>& goals, const Grid& grid, ReservationTable& reservations,
+    HeuristicCache& heuristics, SearchWorkspace& workspace, std::vector<Path>& paths, SolverStats& stats,
+    Clock::time_point deadline, const SearchControl* control) {
+
+    for (int agent : order) {
+        if (Clock::now() > deadline || isCancelled(control)) return false;
+        paths[agent] = findPathWithReservations(starts[agent], goals[agent], grid, reservations, workspace,
+            heuristics.get(goals[agent]).get(), &stats.lowLevelExpanded, 0, INT_MAX, deadline, control);
+        stats.lowLevelCalls++;
+        if (paths[agent].empty()) return false;
+        reservations.reservePath(paths[agent]);
+    }
+    return true;
+}
+
+SolverResult solvePrioritized(const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid, const PrioritizedOptions& options) {
+
+    PROFILE_PHASE(HIGH_LEVEL);
+    auto startTime = Clock::now();
+    SolverResult result;
+    const int numAgents = static_cast<int>(starts.size());
+
+    std::unique_ptr<HeuristicCache> privateCache;
+    HeuristicCache* heuristics = options.heuristics;
+    if (!heuristics) {
+        privateCache.reset(new HeuristicCache(grid));
+        heuristics = privateCache.get();
+    }
+
+    // Agents with far goals are the hardest to route around the others
+    std::vector<int> distances(numAgents);
+    for (int i = 0; i < numAgents; ++i) {
+        auto table = heuristics->get(goals[i]);
+        const int startCell = grid.toId(starts[i]);
+        if (grid.isBlocked(starts[i]) || !table->reachable(startCell)) {
+            result.stats.runtimeSeconds = secondsSince(startTime);
+            return result;  // No order can help an agent that cannot reach its goal at all
+        }
+        distances[i] = table->at(startCell);
+        result.lowerBound += distances[i];
+    }
+    std::vector<int> order(numAgents);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return distances[a] > distances[b]; });
+
+    const auto deadline = startTime + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.timeLimitSeconds));
+    std::mt19937 rng(options.seed);
+    SearchWorkspace workspace;
+    ReservationTable reservations(grid);
+    std::vector<Path> paths(numAgents);
+    for (int attempt = 0; attempt <= options.maxRestarts; ++attempt) {
+        if (Clock::now() > deadline || isCancelled(options.control)) break;
+        if (attempt > 0) std::shuffle(order.begin(), order.end(), rng);
+        result.stats.highLevelExpanded++;
+        publishProgress(options.control, result.stats.highLevelExpanded, result.lowerBound, -1);
+
+        reservations.clear();
+        if (planInOrder(order, starts, goals, grid, reservations, *heuristics, workspace, paths, result.stats,
+            deadline, options.control)) {
+            result.solved = true;
+            result.paths = paths;
+            for (const auto& path : paths) {
+                result.sumOfCosts += pathCost(path);
+                result.makespan = std::max(result.makespan, pathCost(path));
+            }
+            break;
+        }
+    }
+    result.stats.highLevelGenerated = result.stats.highLevelExpanded;
+    result.stats.runtimeSeconds = secondsSince(startTime);
+    result.stats.workerSeconds = result.stats.runtimeSeconds;
+    return result;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "HeuristicCache.h"
+#include "SearchControl.h"
+#include "SearchWorkspace.h"
+#include "ReservationTable.h"
+#include <chrono>
+
+struct PrioritizedOptions {
+    double timeLimitSeconds = 60.0;
+    int maxRestarts = 20;          // Random orders tried after the first one fails
+    unsigned seed = 0;             // Of the restart orders
+    HeuristicCache* heuristics = nullptr;  // Shared distance tables; a private cache is used if null
+    SearchControl* control = nullptr;      // Progress and cancellation, optional
+};
+
+// Plans the agents in 'order' one after another, each against 'reservations'
+// and the agents before it, and reserves every path found. Paths are written to
+// 'paths' (indexed by agent). Returns false as soon as an agent has no path,
+// or before planning an agent once 'deadline' has passed or 'control' is
+// cancelled.
+bool planInOrder(const std::vector<int>& order, const std::vector<Position>& starts,
+    const std::vector<Position>& goals, const Grid& grid, ReservationTable& reservations,
+    HeuristicCache& heuristics, SearchWorkspace& workspace, std::vector<Path>& paths, SolverStats& stats,
+    std::chrono::steady_clock::time_point deadline, const SearchControl* control);
+
+// Prioritized planning (Silver 2005): agents are planned one at a time in a
+// fixed order against a space-time reservation table of the agents before
+// them. The first order puts the agents with the longest shortest paths first;
+// if some agent is then boxed in, random orders are tried until one works or
+// the restarts run out. Fast but neither complete nor optimal. The result's
+// lowerBound is the sum of the agents' shortest path lengths.
+SolverResult solvePrioritized(const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid, const PrioritizedOptions& options = PrioritizedOptions());
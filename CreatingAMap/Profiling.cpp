@@ -0,0 +1,131 @@
+#include "Profiling.h"
+#include <sstream>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    const int NO_PHASE = -1;
+
+    // Per thread: the profile counted into, and the running phase since when
+    thread_local SearchProfile* threadProfile = nullptr;
+    thread_local int activePhase = NO_PHASE;
+    thread_local Clock::time_point phaseStart;
+
+    // Charges the running phase up to 'now' and restarts its clock.
+    void chargeActivePhase(Clock::time_point now) {
+        if (threadProfile && activePhase != NO_PHASE) {
+            threadProfile->addTime(static_cast<ProfilePhase>(activePhase), now - phaseStart);
+        }
+        phaseStart = now;
+    }
+}
+
+const char* profileCounterName(ProfileCounter counter) {
+    switch (counter) {
+    case LOW_LEVEL_CALLS: return "low_level_calls";
+    case LOW_LEVEL_EXPANDED: return "low_level_expanded";
+    case LOW_LEVEL_GENERATED: return "low_level_generated";
+    case HEAP_PUSHES: return "heap_pushes";
+    case HEAP_POPS: return "heap_pops";
+    case CT_NODES_EXPANDED: return "ct_nodes_expanded";
+    case CT_NODES_GENERATED: return "ct_nodes_generated";
+    case ICT_NODES_EVALUATED: return "ict_nodes_evaluated";
+    case ICT_NODES_GENERATED: return "ict_nodes_generated";
+    case VERTEX_CONFLICTS: return "vertex_conflicts";
+    case EDGE_CONFLICTS: return "edge_conflicts";
+    default: return "?";
+    }
+}
+
+const char* profilePhaseName(ProfilePhase phase) {
+    switch (phase) {
+    case HIGH_LEVEL: return "high_level";
+    case LOW_LEVEL_SEARCH: return "low_level_search";
+    case CONFLICT_DETECTION: return "conflict_detection";
+    default: return "?";
+    }
+}
+
+double ProfileSnapshot::expandedPerCall() const {
+    const long long calls = counters[LOW_LEVEL_CALLS];
+    return calls > 0 ? static_cast<double>(counters[LOW_LEVEL_EXPANDED]) / calls : 0.0;
+}
+
+double ProfileSnapshot::generatedPerCall() const {
+    const long long calls = counters[LOW_LEVEL_CALLS];
+    return calls > 0 ? static_cast<double>(counters[LOW_LEVEL_GENERATED]) / calls : 0.0;
+}
+
+std::string ProfileSnapshot::toJson() const {
+    std::ostringstream out;
+    out << "{";
+    for (int i = 0; i < NUM_PROFILE_COUNTERS; ++i) {
+        out << (i > 0 ? ", " : "") << "\"" << profileCounterName(static_cast<ProfileCounter>(i)) << "\": " << counters[i];
+    }
+    out << ", \"expanded_per_call\": " << expandedPerCall()
+        << ", \"generated_per_call\": " << generatedPerCall()
+        << ", \"max_expanded_per_call\": " << maxExpandedPerCall;
+    for (int i = 0; i < NUM_PROFILE_PHASES; ++i) {
+        out << ", \"" << profilePhaseName(static_cast<ProfilePhase>(i)) << "_s\": " << phaseSeconds[i];
+    }
+    out << "}";
+    return out.str();
+}
+
+SearchProfile::SearchProfile() {
+    reset();
+}
+
+void SearchProfile::addLowLevelCall(long long expanded) {
+    add(LOW_LEVEL_CALLS, 1);
+    add(LOW_LEVEL_EXPANDED, expanded);
+    long long largest = maxExpandedPerCall.load(std::memory_order_relaxed);
+    while (expanded > largest && !maxExpandedPerCall.compare_exchange_weak(largest, expanded, std::memory_order_relaxed)) {
+    }
+}
+
+void SearchProfile::reset() {
+    for (auto& counter : counters) counter.store(0);
+    for (auto& nanoseconds : phaseNanoseconds) nanoseconds.store(0);
+    maxExpandedPerCall.store(0);
+}
+
+ProfileSnapshot SearchProfile::snapshot() const {
+    ProfileSnapshot snapshot;
+    for (int i = 0; i < NUM_PROFILE_COUNTERS; ++i) {
+        snapshot.counters[i] = counters[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < NUM_PROFILE_PHASES; ++i) {
+        snapshot.phaseSeconds[i] = phaseNanoseconds[i].load(std::memory_order_relaxed) * 1e-9;
+    }
+    snapshot.maxExpandedPerCall = maxExpandedPerCall.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+SearchProfile* currentProfile() {
+    return threadProfile;
+}
+
+ProfileScope::ProfileScope(SearchProfile* profile) : previous(threadProfile), previousPhase(activePhase) {
+    chargeActivePhase(Clock::now());
+    threadProfile = profile;
+    activePhase = NO_PHASE;
+}
+
+ProfileScope::~ProfileScope() {
+    chargeActivePhase(Clock::now());
+    threadProfile = previous;
+    activePhase = previousPhase;
+}
+
+PhaseTimer::PhaseTimer(ProfilePhase phase) : profile(threadProfile), previousPhase(activePhase) {
+    if (!profile) return;
+    chargeActivePhase(Clock::now());
+    activePhase = phase;
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (!profile) return;
+    chargeActivePhase(Clock::now());
+    activePhase = previousPhase;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+// Optional instrumentation of the solvers. Built with MAPF_PROFILE defined, the
+// solvers count their work and time their phases into the SearchProfile that
+// is installed on the calling thread with a ProfileScope; tasks of a
+// ThreadPool and the CBS worker threads count into the profile of the thread
+// that started them. Without MAPF_PROFILE the PROFILE_ hooks at the end of
+// this file compile to nothing.
+
+enum ProfileCounter {
+    LOW_LEVEL_CALLS,
+    LOW_LEVEL_EXPANDED,
+    LOW_LEVEL_GENERATED,
+    HEAP_PUSHES,          // Open and focal lists of the low-level searches
+    HEAP_POPS,
+    CT_NODES_EXPANDED,    // CBS and ECBS
+    CT_NODES_GENERATED,
+    ICT_NODES_EVALUATED,
+    ICT_NODES_GENERATED,
+    VERTEX_CONFLICTS,     // Found by the conflict detector
+    EDGE_CONFLICTS,
+    NUM_PROFILE_COUNTERS
+};
+
+// Time goes to the innermost running phase only, so the phases add up to the
+// time spent in the solvers.
+enum ProfilePhase {
+    HIGH_LEVEL,           // Node selection, branching and other bookkeeping
+    LOW_LEVEL_SEARCH,     // Single-agent searches and MDD construction
+    CONFLICT_DETECTION,   // Conflict checks between paths; the joint MDD search of ICTS
+    NUM_PROFILE_PHASES
+};
+
+const char* profileCounterName(ProfileCounter counter);
+const char* profilePhaseName(ProfilePhase phase);
+
+// Copy of a profile at one point in time.
+struct ProfileSnapshot {
+    long long counters[NUM_PROFILE_COUNTERS] = {};
+    double phaseSeconds[NUM_PROFILE_PHASES] = {};
+    long long maxExpandedPerCall = 0;
+
+    double expandedPerCall() const;
+    double generatedPerCall() const;
+    // One JSON object with every counter and phase.
+    std::string toJson() const;
+};
+
+// Totals of one solve. Threads add to it concurrently, and snapshot() may be
+// called at any time, also from another thread while the solve runs.
+class SearchProfile {
+public:
+    SearchProfile();
+
+    void add(ProfileCounter counter, long long amount) {
+        counters[counter].fetch_add(amount, std::memory_order_relaxed);
+    }
+    void addTime(ProfilePhase phase, std::chrono::steady_clock::duration elapsed) {
+        phaseNanoseconds[phase].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+            std::memory_order_relaxed);
+    }
+    // Counts one low-level call that expanded 'expanded' nodes.
+    void addLowLevelCall(long long expanded);
+
+    void reset();
+    ProfileSnapshot snapshot() const;
+
+private:
+    std::atomic<long long> counters[NUM_PROFILE_COUNTERS];
+    std::atomic<long long> phaseNanoseconds[NUM_PROFILE_PHASES];
+    std::atomic<long long> maxExpandedPerCall;
+};
+
+// The profile the current thread counts into; nullptr if there is none.
+SearchProfile* currentProfile();
+
+inline void profileCount(ProfileCounter counter, long long amount) {
+    if (SearchProfile* profile = currentProfile()) profile->add(counter, amount);
+}
+
+// Makes 'profile' the current thread's profile until the end of the scope.
+// A phase that is running is charged to the previous profile up to here.
+class ProfileScope {
+public:
+    explicit ProfileScope(SearchProfile* profile);
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    SearchProfile* previous;
+    int previousPhase;
+};
+
+// Charges the time until the end of the scope to 'phase'; the phase that was
+// running is paused meanwhile. Does nothing if the thread has no profile.
+class PhaseTimer {
+public:
+    explicit PhaseTimer(ProfilePhase phase);
+    ~PhaseTimer();
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    SearchProfile* profile;
+    int previousPhase;
+};
+
+#ifdef MAPF_PROFILE
+const bool PROFILING_ENABLED = true;
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_PHASE(phase) PhaseTimer PROFILE_CONCAT(phaseTimer, __LINE__)(phase)
+#define PROFILE_COUNT(counter, amount) profileCount(counter, amount)
+#define PROFILE_ONLY(...) __VA_ARGS__
+#else
+const bool PROFILING_ENABLED = false;
+#define PROFILE_PHASE(phase) do {} while (0)
+#define PROFILE_COUNT(counter, amount) do {} while (0)
+#define PROFILE_ONLY(...)
+#endif
@@ -0,0 +1,90 @@
+#include "ReservationTable.h"
+#include <algorithm>
+
+namespace {
+    uint64_t cellKey(int cell, int timestep) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(timestep)) << 32) | static_cast<uint32_t>(cell);
+    }
+
+    void release(std::unordered_map<uint64_t, int>& counts, uint64_t key) {
+        auto it = counts.find(key);
+        if (it != counts.end() && --it->second == 0) counts.erase(it);
+    }
+}
+
+ReservationTable::ReservationTable(const Grid& grid) : grid(grid) {
+}
+
+uint64_t ReservationTable::moveKey(int fromCell, int toCell, int timestep) const {
+    const int* offsets = grid.getNeighborOffsets();
+    uint64_t direction = 0;
+    while (direction < Grid::NUM_DIRECTIONS && fromCell + offsets[direction] != toCell) ++direction;
+    return (cellKey(toCell, timestep) << 2) | direction;
+}
+
+void ReservationTable::reservePath(const Path& path, int startTime) {
+    if (path.empty()) return;
+    const int last = pathCost(path);
+    int previous = -1;
+    for (int i = 0; i <= last; ++i) {
+        const int t = startTime + i;
+        const int cell = grid.toId(path[i]);
+        cells[cellKey(cell, t)]++;
+        if (previous >= 0 && previous != cell) moves[moveKey(previous, cell, t)]++;
+        if (i < last) {
+            int& visit = lastVisit.emplace(cell, t).first->second;
+            visit = std::max(visit, t);
+        }
+        previous = cell;
+    }
+    parkedFrom.emplace(previous, startTime + last);
+    maxTimestep = std::max(maxTimestep, startTime + last);
+}
+
+void ReservationTable::releasePath(const Path& path, int startTime) {
+    if (path.empty()) return;
+    const int last = pathCost(path);
+    int previous = -1;
+    for (int i = 0; i <= last; ++i) {
+        const int t = startTime + i;
+        const int cell = grid.toId(path[i]);
+        release(cells, cellKey(cell, t));
+        if (previous >= 0 && previous != cell) release(moves, moveKey(previous, cell, t));
+        previous = cell;
+    }
+    auto range = parkedFrom.equal_range(previous);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == startTime + last) {
+            parkedFrom.erase(it);
+            break;
+        }
+    }
+}
+
+void ReservationTable::clear() {
+    cells.clear();
+    moves.clear();
+    parkedFrom.clear();
+    lastVisit.clear();
+    maxTimestep = -1;
+}
+
+bool ReservationTable::isReserved(int cell, int timestep) const {
+    if (!parkedFrom.empty()) {
+        auto range = parkedFrom.equal_range(cell);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (timestep >= it->second) return true;
+        }
+    }
+    return timestep <= maxTimestep && cells.count(cellKey(cell, timestep)) > 0;
+}
+
+bool ReservationTable::isMoveReserved(int fromCell, int toCell, int timestep) const {
+    return !moves.empty() && timestep <= maxTimestep && moves.count(moveKey(toCell, fromCell, timestep)) > 0;
+}
+
+int ReservationTable::getEarliestStayTime(int cell) const {
+    if (parkedFrom.count(cell)) return -1;
+    auto it = lastVisit.find(cell);
+    return it == lastVisit.end() ? 0 : it->second + 1;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include <unordered_set>
+#include <unordered_map>
+#include <cstdint>
+
+// Space-time reservations of the agents planned so far, as prioritized planners
+// use them. A reserved path occupies its cell at every timestep and blocks the
+// reverse of each of its moves. After its last step the agent stays at its goal
+// for good, so that cell is reserved from then on (goal-stay semantics).
+// Timesteps are absolute: a path reserved with 'startTime' t is at path[0] at t.
+class ReservationTable {
+public:
+    explicit ReservationTable(const Grid& grid);
+
+    void reservePath(const Path& path, int startTime = 0);
+    // Takes back a path reserved earlier with the same start time. The goal-stay
+    // times it raised are kept, which only makes later agents stop later.
+    void releasePath(const Path& path, int startTime = 0);
+    void clear();
+
+    bool isReserved(int cell, int timestep) const;
+    // Whether moving from 'fromCell' to 'toCell', arriving at 'timestep', swaps
+    // places with a reserved agent.
+    bool isMoveReserved(int fromCell, int toCell, int timestep) const;
+    // Earliest timestep from which an agent may stay at 'cell' for good; -1 if
+    // another agent ends its path there.
+    int getEarliestStayTime(int cell) const;
+    // Last timestep of any reserved path. After it the table no longer changes.
+    int getMaxTimestep() const { return maxTimestep; }
+
+    bool empty() const { return cells.empty() && parkedFrom.empty(); }
+    const Grid& getGrid() const { return grid; }
+
+private:
+    uint64_t moveKey(int fromCell, int toCell, int timestep) const;
+
+    const Grid& grid;
+    // Reservations per (cell, timestep) and per (from, to, timestep) move. They
+    // are counted, since paths beyond a planning horizon may overlap.
+    std::unordered_map<uint64_t, int> cells;
+    std::unordered_map<uint64_t, int> moves;
+    std::unordered_multimap<int, int> parkedFrom;  // Goal cell -> timestep its agent arrives for good
+    std::unordered_map<int, int> lastVisit;        // Cell -> last timestep it is reserved by a passing agent
+    int maxTimestep = -1;
+};
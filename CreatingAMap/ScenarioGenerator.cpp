@@ -0,0 +1,129 @@
+#include "ScenarioGenerator.h"
+#include "ThreadPool.h"
+#include <iostream>
+#include <random>
+#include <atomic>
+#include <mutex>
+
+ScenarioGenerator::ScenarioGenerator(const Grid& grid) : grid(grid) {
+    // Counting sort of the free cells by component; single-cell components
+    // cannot hold a start and a different goal and are left out
+    const int numComponents = grid.getComponentCount();
+    std::vector<int> componentSize(numComponents, 0);
+    for (int id = 0; id < grid.getCellCount(); ++id) {
+        if (!grid.isBlocked(id)) componentSize[grid.getComponent(id)]++;
+    }
+    componentBegin.assign(numComponents + 1, 0);
+    for (int c = 0; c < numComponents; ++c) {
+        componentBegin[c + 1] = componentBegin[c] + (componentSize[c] >= 2 ? componentSize[c] : 0);
+    }
+    cells.resize(componentBegin[numComponents]);
+    std::vector<int> next(componentBegin.begin(), componentBegin.end() - 1);
+    for (int id = 0; id < grid.getCellCount(); ++id) {
+        if (grid.isBlocked(id)) continue;
+        const int component = grid.getComponent(id);
+        if (componentSize[component] >= 2) cells[next[component]++] = id;
+    }
+}
+
+int ScenarioGenerator::shortestPathLength(int start, int goal, std::vector<int>& visited, int stamp,
+    std::vector<int>& queue) const {
+
+    // Breadth-first, one layer per step, stopping at the goal
+    const int* offsets = grid.getNeighborOffsets();
+    queue.clear();
+    queue.push_back(start);
+    visited[start] = stamp;
+    int length = 0;
+    size_t layerBegin = 0;
+    while (layerBegin < queue.size()) {
+        const size_t layerEnd = queue.size();
+        for (size_t i = layerBegin; i < layerEnd; ++i) {
+            const int cell = queue[i];
+            if (cell == goal) return length;
+            for (int d = 0; d < Grid::NUM_DIRECTIONS; ++d) {
+                const int neighbor = cell + offsets[d];
+                if (grid.isBlocked(neighbor) || visited[neighbor] == stamp) continue;
+                visited[neighbor] = stamp;
+                queue.push_back(neighbor);
+            }
+        }
+        layerBegin = layerEnd;
+        length++;
+    }
+    return -1;
+}
+
+bool ScenarioGenerator::generate(uint64_t seed, int numAgents, std::vector<ScenarioEntry>& entries) const {
+    entries.clear();
+    if (numAgents > getCapacity()) {
+        std::cerr << "Cannot place " << numAgents << " agents, the map holds at most " << getCapacity() << std::endl;
+        return false;
+    }
+
+    std::mt19937_64 random(seed);
+    std::vector<uint8_t> usedStart(grid.getCellCount(), 0);
+    std::vector<uint8_t> usedGoal(grid.getCellCount(), 0);
+    std::vector<int> visited(grid.getCellCount(), 0);
+    std::vector<int> queue;
+    entries.reserve(numAgents);
+
+    // Rejection sampling; the modulo bias of 64-bit draws is negligible
+    const long long maxAttempts = 1000LL * numAgents;
+    for (long long attempts = 0; static_cast<int>(entries.size()) < numAgents && attempts < maxAttempts; ++attempts) {
+        const int start = cells[random() % cells.size()];
+        if (usedStart[start]) continue;
+        const int component = grid.getComponent(start);
+        const int begin = componentBegin[component];
+        const int size = componentBegin[component + 1] - begin;
+        const int goal = cells[begin + random() % size];
+        if (goal == start || usedGoal[goal]) continue;
+
+        usedStart[start] = 1;
+        usedGoal[goal] = 1;
+        ScenarioEntry entry;
+        entry.optimalLength = shortestPathLength(start, goal, visited, static_cast<int>(entries.size()) + 1, queue);
+        entry.bucket = static_cast<int>(entry.optimalLength) / 4;
+        entry.mapWidth = grid.getWidth();
+        entry.mapHeight = grid.getHeight();
+        entry.start = grid.toPosition(start);
+        entry.goal = grid.toPosition(goal);
+        entries.push_back(entry);
+    }
+    if (static_cast<int>(entries.size()) < numAgents) {
+        std::cerr << "Placed only " << entries.size() << " of " << numAgents << " agents" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+uint64_t ScenarioGenerator::instanceSeed(uint64_t seed, int index) {
+    // SplitMix64 finalizer
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(index + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+int writeRandomScenarios(const ScenarioGenerator& generator, const std::string& mapName, const std::string& prefix,
+    int count, int numAgents, uint64_t seed, int numThreads) {
+
+    std::atomic<int> written(0);
+    std::mutex logMutex;
+    ThreadPool pool(numThreads);
+    for (int i = 1; i <= count; ++i) {
+        pool.submit([&, i]() {
+            const std::string filename = prefix + "-random-" + std::to_string(i) + ".scen";
+            std::vector<ScenarioEntry> entries;
+            bool ok = generator.generate(ScenarioGenerator::instanceSeed(seed, i), numAgents, entries)
+                && writeScenarioFile(filename, mapName, entries);
+            if (ok) written++;
+            else {
+                std::lock_guard<std::mutex> lock(logMutex);
+                std::cerr << "Failed to generate " << filename << std::endl;
+            }
+            });
+    }
+    pool.wait();
+    return written;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "MovingAI.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Reproducible random instances on one map. Starts and goals are free cells, no
+// two agents share a start or a goal, no agent starts on its goal, and every
+// goal lies in its start's connected component, so each agent can reach its
+// goal on its own. The same seed gives the same instance on every platform:
+// numbers come from std::mt19937_64, whose output the standard fixes, and are
+// mapped to ranges here rather than by the implementation-defined
+// distributions. generate() may run on several threads at once.
+class ScenarioGenerator {
+public:
+    // The grid needs its components (loaded grids have them) and must outlive
+    // the generator.
+    explicit ScenarioGenerator(const Grid& grid);
+
+    // Most agents a scenario can hold: one per free cell that has a neighbour
+    // in its component.
+    int getCapacity() const { return static_cast<int>(cells.size()); }
+
+    // Draws 'numAgents' agents. The entries carry the map size, the length of a
+    // shortest path and its MovingAI bucket (length / 4). Fails if the agents
+    // do not fit on the map.
+    bool generate(uint64_t seed, int numAgents, std::vector<ScenarioEntry>& entries) const;
+
+    // Seed of the index-th instance of a set, well spread even for
+    // neighbouring indices and base seeds.
+    static uint64_t instanceSeed(uint64_t seed, int index);
+
+private:
+    int shortestPathLength(int start, int goal, std::vector<int>& visited, int stamp, std::vector<int>& queue) const;
+
+    const Grid& grid;
+    std::vector<int> cells;            // Usable free cells, grouped by component
+    std::vector<int> componentBegin;   // Component c owns cells[componentBegin[c], componentBegin[c + 1])
+};
+
+// Writes scenarios 1..count of 'numAgents' agents as
+// prefix + "-random-<i>.scen", instance i drawn from instanceSeed(seed, i),
+// on 'numThreads' threads. Returns the number of files written.
+int writeRandomScenarios(const ScenarioGenerator& generator, const std::string& mapName, const std::string& prefix,
+    int count, int numAgents, uint64_t seed, int numThreads);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <atomic>
+
+// Lets another thread follow and stop a running search, e.g. a UI that plans in
+// the background. The solver publishes its progress as it expands high-level
+// nodes and polls 'cancelled' between them; a cancelled search returns an
+// unsolved result shortly after.
+struct SearchControl {
+    std::atomic<bool> cancelled{ false };
+    std::atomic<long long> nodesExpanded{ 0 };  // High-level nodes expanded (CT nodes, ICT nodes)
+    std::atomic<int> costBound{ 0 };            // Sum of costs of the best open node / current level
+    std::atomic<int> conflicts{ -1 };           // Conflicts left in the best open node; -1 if not tracked
+
+    void cancel() { cancelled.store(true); }
+};
+
+inline bool isCancelled(const SearchControl* control) {
+    return control && control->cancelled.load(std::memory_order_relaxed);
+}
+
+inline void publishProgress(SearchControl* control, long long nodesExpanded, int costBound, int conflicts) {
+    if (!control) return;
+    control->nodesExpanded.store(nodesExpanded, std::memory_order_relaxed);
+    control->costBound.store(costBound, std::memory_order_relaxed);
+    control->conflicts.store(conflicts, std::memory_order_relaxed);
+}
@@ -0,0 +1,150 @@
+#include "SearchWorkspace.h"
+
+namespace {
+    const size_t INITIAL_SET_CAPACITY = 1024;  // Must be a power of two
+}
+
+void StampedKeySet::clear() {
+    count = 0;
+    if (++generation == 0) {
+        // The counter wrapped around, so old stamps could look current again
+        std::fill(stamps.begin(), stamps.end(), 0);
+        generation = 1;
+    }
+}
+
+size_t StampedKeySet::slotOf(uint64_t key) const {
+    // Fibonacci hashing spreads the (cell, timestep) keys over the table
+    uint64_t h = key * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(h >> 32) & (keys.size() - 1);
+}
+
+bool StampedKeySet::insert(uint64_t key) {
+    if ((count + 1) * 2 > keys.size()) grow();
+
+    size_t mask = keys.size() - 1;
+    for (size_t slot = slotOf(key);; slot = (slot + 1) & mask) {
+        if (stamps[slot] != generation) {
+            stamps[slot] = generation;
+            keys[slot] = key;
+            ++count;
+            return true;
+        }
+        if (keys[slot] == key) return false;
+    }
+}
+
+bool StampedKeySet::contains(uint64_t key) const {
+    if (keys.empty()) return false;
+
+    size_t mask = keys.size() - 1;
+    for (size_t slot = slotOf(key);; slot = (slot + 1) & mask) {
+        if (stamps[slot] != generation) return false;
+        if (keys[slot] == key) return true;
+    }
+}
+
+void StampedKeySet::grow() {
+    std::vector<uint64_t> oldKeys;
+    std::vector<uint32_t> oldStamps;
+    oldKeys.swap(keys);
+    oldStamps.swap(stamps);
+
+    size_t capacity = oldKeys.empty() ? INITIAL_SET_CAPACITY : oldKeys.size() * 2;
+    keys.assign(capacity, 0);
+    stamps.assign(capacity, 0);
+
+    uint32_t oldGeneration = generation;
+    generation = 1;
+    count = 0;
+    for (size_t i = 0; i < oldKeys.size(); ++i) {
+        if (oldStamps[i] == oldGeneration) insert(oldKeys[i]);
+    }
+}
+
+void StampedKeyMap::clear() {
+    count = 0;
+    if (++generation == 0) {
+        std::fill(stamps.begin(), stamps.end(), 0);
+        generation = 1;
+    }
+}
+
+size_t StampedKeyMap::slotOf(uint64_t key) const {
+    uint64_t h = key * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(h >> 32) & (keys.size() - 1);
+}
+
+int* StampedKeyMap::find(uint64_t key) {
+    if (keys.empty()) return nullptr;
+
+    size_t mask = keys.size() - 1;
+    for (size_t slot = slotOf(key);; slot = (slot + 1) & mask) {
+        if (stamps[slot] != generation) return nullptr;
+        if (keys[slot] == key) return &values[slot];
+    }
+}
+
+void StampedKeyMap::set(uint64_t key, int value) {
+    if ((count + 1) * 2 > keys.size()) grow();
+
+    size_t mask = keys.size() - 1;
+    for (size_t slot = slotOf(key);; slot = (slot + 1) & mask) {
+        if (stamps[slot] != generation) {
+            stamps[slot] = generation;
+            keys[slot] = key;
+            values[slot] = value;
+            ++count;
+            return;
+        }
+        if (keys[slot] == key) {
+            values[slot] = value;
+            return;
+        }
+    }
+}
+
+void StampedKeyMap::grow() {
+    std::vector<uint64_t> oldKeys;
+    std::vector<int> oldValues;
+    std::vector<uint32_t> oldStamps;
+    oldKeys.swap(keys);
+    oldValues.swap(values);
+    oldStamps.swap(stamps);
+
+    size_t capacity = oldKeys.empty() ? INITIAL_SET_CAPACITY : oldKeys.size() * 2;
+    keys.assign(capacity, 0);
+    values.assign(capacity, 0);
+    stamps.assign(capacity, 0);
+
+    uint32_t oldGeneration = generation;
+    generation = 1;
+    count = 0;
+    for (size_t i = 0; i < oldKeys.size(); ++i) {
+        if (oldStamps[i] == oldGeneration) set(oldKeys[i], oldValues[i]);
+    }
+}
+
+void SearchWorkspace::beginQuery(int cellCount) {
+    if (static_cast<int>(cellStamp.size()) < cellCount) {
+        cellStamp.assign(cellCount, 0);
+        cellG.resize(cellCount);
+        cellParent.resize(cellCount);
+        cellClosed.resize(cellCount);
+        generation = 0;
+    }
+    if (++generation == 0) {
+        std::fill(cellStamp.begin(), cellStamp.end(), 0);
+        generation = 1;
+    }
+
+    open.clear();
+    nodes.clear();
+    closedStates.clear();
+    nodeConflicts.clear();
+    nodeOpen.clear();
+    bestNodes.clear();
+    focalOpen.clear();
+    focalWaiting.clear();
+    focal.clear();
+}
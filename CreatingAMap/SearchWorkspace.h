@@ -0,0 +1,153 @@
+#pragma once
+
+#include "Profiling.h"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Entry of the A* open list. 'node' is a cell id for spatial searches and an
+// index into SearchWorkspace::nodes for space-time searches.
+struct OpenEntry {
+    int f, g;
+    int node;
+};
+
+// Orders the open list as a min-heap on f, preferring deeper nodes on ties.
+struct OpenEntryCompare {
+    bool operator()(const OpenEntry& a, const OpenEntry& b) const {
+        if (a.f != b.f) return a.f > b.f;
+        return a.g < b.g;
+    }
+};
+
+// Space-time search node kept in the workspace pool.
+struct SpaceTimeNode {
+    int cell;
+    int g;
+    int parent;  // Index into the pool, -1 for the root
+};
+
+// Entry of the focal list of the ECBS low level: fewest conflicts first, then
+// as in the open list. 'node' indexes SearchWorkspace::nodes.
+struct FocalEntry {
+    int conflicts, f, g;
+    int node;
+};
+
+struct FocalEntryCompare {
+    bool operator()(const FocalEntry& a, const FocalEntry& b) const {
+        if (a.conflicts != b.conflicts) return a.conflicts > b.conflicts;
+        if (a.f != b.f) return a.f > b.f;
+        if (a.g != b.g) return a.g < b.g;
+        return a.node > b.node;
+    }
+};
+
+// Open-addressing set of 64-bit keys. Clearing only bumps a generation counter,
+// so the storage is reused across queries without being touched.
+class StampedKeySet {
+public:
+    StampedKeySet() : generation(1), count(0) {}
+
+    void clear();
+    // Returns false if the key was already present.
+    bool insert(uint64_t key);
+    bool contains(uint64_t key) const;
+
+private:
+    size_t slotOf(uint64_t key) const;
+    void grow();
+
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> stamps;
+    uint32_t generation;
+    size_t count;
+};
+
+// StampedKeySet with an int value per key, cleared the same way.
+class StampedKeyMap {
+public:
+    StampedKeyMap() : generation(1), count(0) {}
+
+    void clear();
+    // The value of 'key', nullptr if absent. Valid until the next set().
+    int* find(uint64_t key);
+    void set(uint64_t key, int value);
+
+private:
+    size_t slotOf(uint64_t key) const;
+    void grow();
+
+    std::vector<uint64_t> keys;
+    std::vector<int> values;
+    std::vector<uint32_t> stamps;
+    uint32_t generation;
+    size_t count;
+};
+
+// Scratch memory for the low-level searches. One workspace is reused for every
+// query of a solver (or of a solver thread), so steady-state searches do no
+// heap allocation: per-cell arrays are invalidated in O(1) through generation
+// stamps, and all other buffers keep their capacity between queries.
+class SearchWorkspace {
+public:
+    SearchWorkspace() : generation(1) {}
+
+    // Starts a new query over a grid with 'cellCount' cell ids.
+    void beginQuery(int cellCount);
+
+    // Per-cell data of the current query (spatial search).
+    bool isVisited(int cell) const { return cellStamp[cell] == generation; }
+    void visit(int cell, int g, int parent) {
+        cellStamp[cell] = generation;
+        cellG[cell] = g;
+        cellParent[cell] = parent;
+        cellClosed[cell] = 0;
+    }
+    int getG(int cell) const { return cellG[cell]; }
+    int getParent(int cell) const { return cellParent[cell]; }
+    bool isClosed(int cell) const { return cellClosed[cell] != 0; }
+    void close(int cell) { cellClosed[cell] = 1; }
+
+    // Binary-heap open list.
+    void pushOpen(const OpenEntry& entry) {
+        PROFILE_ONLY(heapPushes++;)
+        open.push_back(entry);
+        std::push_heap(open.begin(), open.end(), OpenEntryCompare());
+    }
+    OpenEntry popOpen() {
+        PROFILE_ONLY(heapPops++;)
+        std::pop_heap(open.begin(), open.end(), OpenEntryCompare());
+        OpenEntry top = open.back();
+        open.pop_back();
+        return top;
+    }
+    bool openEmpty() const { return open.empty(); }
+
+    // Node pool and closed set for space-time searches.
+    std::vector<SpaceTimeNode> nodes;
+    StampedKeySet closedStates;
+
+    // Focal search (ECBS low level): per node its conflicts and whether it is
+    // still open, the best node of each state, min-f heaps of the open nodes
+    // and of those outside the focal bound, and the focal heap itself. Stale
+    // heap entries are skipped when popped.
+    std::vector<int> nodeConflicts;
+    std::vector<uint8_t> nodeOpen;
+    StampedKeyMap bestNodes;
+    std::vector<OpenEntry> focalOpen;
+    std::vector<OpenEntry> focalWaiting;
+    std::vector<FocalEntry> focal;
+
+    // Heap operations of all queries so far; only counted with MAPF_PROFILE
+    long long heapPushes = 0;
+    long long heapPops = 0;
+
+private:
+    uint32_t generation;
+    std::vector<uint32_t> cellStamp;
+    std::vector<int> cellG;
+    std::vector<int> cellParent;
+    std::vector<uint8_t> cellClosed;
+    std::vector<OpenEntry> open;
+};
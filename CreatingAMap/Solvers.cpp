@@ -0,0 +1,122 @@
+#include "Solvers.h"
+#include "CBS.h"
+#include "ICTS.h"
+#include "ECBS.h"
+#include "PrioritizedPlanning.h"
+#include "PBS.h"
+#include "LNS.h"
+#include "IndependenceDetection.h"
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+const char* algorithmName(Algorithm algorithm) {
+    switch (algorithm) {
+    case CBS: return "CBS";
+    case ICTS: return "ICTS";
+    case ECBS: return "ECBS";
+    case PP: return "PP";
+    case PBS: return "PBS";
+    case LNS: return "LNS";
+    }
+    return "?";
+}
+
+bool parseAlgorithm(const std::string& name, Algorithm& algorithm) {
+    std::string upper = name;
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    for (Algorithm candidate : { CBS, ICTS, ECBS, PP, PBS, LNS }) {
+        if (upper == algorithmName(candidate)) {
+            algorithm = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<int> findUnreachableAgents(const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid) {
+
+    std::vector<int> agents;
+    for (size_t i = 0; i < starts.size(); ++i) {
+        if (grid.isBlocked(starts[i]) || grid.isBlocked(goals[i])
+            || !grid.isConnected(grid.toId(starts[i]), grid.toId(goals[i]))) {
+            agents.push_back(static_cast<int>(i));
+        }
+    }
+    return agents;
+}
+
+SolverResult solve(Algorithm algorithm, const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid, const SolveOptions& options) {
+
+    // No solver could succeed; fail before one spends its time limit finding out
+    std::vector<int> unreachable = findUnreachableAgents(starts, goals, grid);
+    if (!unreachable.empty()) {
+        SolverResult result;
+        result.unreachableAgents = std::move(unreachable);
+        return result;
+    }
+
+    if (options.independenceDetection) {
+        return solveWithIndependenceDetection(algorithm, starts, goals, grid, options);
+    }
+    switch (algorithm) {
+    case ICTS: {
+        ICTSOptions ictsOptions;
+        ictsOptions.timeLimitSeconds = options.timeLimitSeconds;
+        ictsOptions.numThreads = options.numThreads;
+        ictsOptions.heuristics = options.heuristics;
+        ictsOptions.control = options.control;
+        return solveICTS(starts, goals, grid, ictsOptions);
+    }
+    case ECBS: {
+        ECBSOptions ecbsOptions;
+        ecbsOptions.timeLimitSeconds = options.timeLimitSeconds;
+        ecbsOptions.heuristics = options.heuristics;
+        ecbsOptions.control = options.control;
+        ecbsOptions.suboptimality = options.suboptimality;
+        return solveECBS(starts, goals, grid, ecbsOptions);
+    }
+    case PP: {
+        PrioritizedOptions ppOptions;
+        ppOptions.timeLimitSeconds = options.timeLimitSeconds;
+        ppOptions.heuristics = options.heuristics;
+        ppOptions.control = options.control;
+        ppOptions.seed = options.seed;
+        return solvePrioritized(starts, goals, grid, ppOptions);
+    }
+    case PBS: {
+        PBSOptions pbsOptions;
+        pbsOptions.timeLimitSeconds = options.timeLimitSeconds;
+        pbsOptions.heuristics = options.heuristics;
+        pbsOptions.control = options.control;
+        return solvePBS(starts, goals, grid, pbsOptions);
+    }
+    case LNS: {
+        LNSOptions lnsOptions;
+        lnsOptions.timeLimitSeconds = options.timeLimitSeconds;
+        lnsOptions.numThreads = options.numThreads;
+        lnsOptions.heuristics = options.heuristics;
+        lnsOptions.control = options.control;
+        lnsOptions.seed = options.seed;
+        lnsOptions.neighborhoodSize = options.neighborhoodSize;
+        lnsOptions.neighborhood = options.neighborhood;
+        lnsOptions.cbsReplanning = options.cbsReplanning;
+        return solveLNS(starts, goals, grid, lnsOptions);
+    }
+    case CBS:
+    default: {
+        CBSOptions cbsOptions;
+        cbsOptions.timeLimitSeconds = options.timeLimitSeconds;
+        cbsOptions.numThreads = options.numThreads;
+        cbsOptions.heuristics = options.heuristics;
+        cbsOptions.control = options.control;
+        cbsOptions.prioritizeConflicts = options.prioritizeConflicts;
+        cbsOptions.bypass = options.bypass;
+        cbsOptions.rectangleReasoning = options.rectangleReasoning;
+        cbsOptions.corridorReasoning = options.corridorReasoning;
+        return solveCBS(starts, goals, grid, cbsOptions);
+    }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "HeuristicCache.h"
+#include "SearchControl.h"
+#include "LNS.h"
+#include <string>
+
+enum Algorithm { CBS, ICTS, ECBS, PP, PBS, LNS };
+
+const char* algorithmName(Algorithm algorithm);
+// Case-insensitive; returns false for an unknown name.
+bool parseAlgorithm(const std::string& name, Algorithm& algorithm);
+
+// Settings shared by every solver; solver-specific limits keep their defaults.
+struct SolveOptions {
+    double timeLimitSeconds = 60.0;
+    int numThreads = 1;
+    HeuristicCache* heuristics = nullptr;
+    SearchControl* control = nullptr;
+    double suboptimality = 1.2;  // w of the bounded-suboptimal solvers (ECBS)
+    unsigned seed = 0;           // Random restarts of prioritized planning, LNS neighbourhoods
+
+    // Anytime LNS, see LNSOptions; it runs until timeLimitSeconds is used up
+    int neighborhoodSize = 8;
+    Neighborhood neighborhood = ADAPTIVE_NEIGHBORHOOD;
+    bool cbsReplanning = false;
+
+    // CBS improvements, see CBSOptions
+    bool prioritizeConflicts = true;
+    bool bypass = true;
+    bool rectangleReasoning = false;
+    bool corridorReasoning = true;
+
+    // Independence detection in front of the solver, see IndependenceDetection.h
+    bool independenceDetection = false;
+    int groupThreads = 0;  // Groups solved concurrently; 0 for one per core
+};
+
+// Agents whose start or goal is blocked or whose goal lies outside their
+// start's connected component. Constant time per agent.
+std::vector<int> findUnreachableAgents(const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid);
+
+// Runs one of the MAPF solvers, so callers can pick the algorithm at run time.
+// With 'independenceDetection' the solver only sees groups of dependent agents.
+// Instances with unreachable agents fail at once, without running the solver,
+// and list them in 'unreachableAgents'; reporting them is up to the caller.
+SolverResult solve(Algorithm algorithm, const std::vector<Position>& starts, const std::vector<Position>& goals,
+    const Grid& grid, const SolveOptions& options = SolveOptions());
@@ -0,0 +1,58 @@
+#include "ThreadPool.h"
+#include "Profiling.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int numThreads) : running(0), stopping(false) {
+    numThreads = std::max(1, numThreads);
+    for (int i = 0; i < numThreads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+#ifdef MAPF_PROFILE
+    // The task counts into the profile of the thread that submitted it
+    if (SearchProfile* profile = currentProfile()) {
+        task = [profile, task]() {
+            ProfileScope scope(profile);
+            task();
+            };
+    }
+#endif
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    taskAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    allDone.wait(lock, [&]() { return tasks.empty() && running == 0; });
+}
+
+void ThreadPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        taskAvailable.wait(lock, [&]() { return stopping || !tasks.empty(); });
+        if (tasks.empty()) break;  // Stopping and nothing left to do
+
+        std::function<void()> task = std::move(tasks.front());
+        tasks.pop_front();
+        ++running;
+        lock.unlock();
+        task();
+        lock.lock();
+        --running;
+        if (tasks.empty() && running == 0) allDone.notify_all();
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed set of worker threads that run submitted tasks in FIFO order. wait()
+// blocks until every task submitted so far has finished, so a pool can be
+// reused for several rounds of work. Tasks count into the SearchProfile of
+// the submitting thread (see Profiling.h).
+class ThreadPool {
+public:
+    explicit ThreadPool(int numThreads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int getThreadCount() const { return static_cast<int>(workers.size()); }
+
+    void submit(std::function<void()> task);
+    void wait();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable allDone;
+    int running;
+    bool stopping;
+};
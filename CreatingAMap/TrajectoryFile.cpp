@@ -0,0 +1,136 @@
+#include "TrajectoryFile.h"
+#include <iostream>
+#include <cstring>
+#include <cstddef>
+#include <cstdio>
+
+namespace {
+    const char MAGIC[8] = { 'M', 'A', 'P', 'F', 'T', 'R', 'A', 'J' };
+
+    struct RecordHeader {
+        int32_t goalX, goalY;
+        int32_t startX, startY;
+        uint32_t length;
+        uint32_t codeCount;
+    };
+}
+
+bool TrajectoryWriter::open(const std::string& filename, int width, int height) {
+    discard();
+    this->filename = filename;
+    failed = false;
+    out.open(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Cannot write trajectories " << filename << std::endl;
+        return false;
+    }
+    TrajectoryHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    agentCount = 0;
+    failed = !out;
+    return !failed;
+}
+
+bool TrajectoryWriter::write(const Position& start, const Position& goal, const Path& path) {
+    CompactPath compact;
+    if (!compact.encode(path)) {
+        failed = true;
+        return false;
+    }
+
+    RecordHeader record = {};
+    record.goalX = goal.x;
+    record.goalY = goal.y;
+    record.startX = path.empty() ? start.x : path[0].x;
+    record.startY = path.empty() ? start.y : path[0].y;
+    record.length = static_cast<uint32_t>(compact.getLength());
+    record.codeCount = static_cast<uint32_t>(compact.getCodes().size());
+    out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    out.write(reinterpret_cast<const char*>(compact.getCodes().data()), static_cast<std::streamsize>(record.codeCount));
+    agentCount++;
+    if (!out) failed = true;
+    return !failed;
+}
+
+bool TrajectoryWriter::close() {
+    if (!out.is_open()) return true;
+    if (!failed) {
+        out.seekp(offsetof(TrajectoryHeader, agentCount));
+        out.write(reinterpret_cast<const char*>(&agentCount), sizeof(agentCount));
+    }
+    out.close();
+    if (!failed && out) return true;
+    // A file without its agent count would read as a valid empty solution
+    std::remove(filename.c_str());
+    return false;
+}
+
+void TrajectoryWriter::discard() {
+    if (!out.is_open()) return;
+    out.close();
+    std::remove(filename.c_str());
+}
+
+bool TrajectoryReader::open(const std::string& filename) {
+    this->filename = filename;
+    offset = 0;
+    if (!file.open(filename)) {
+        std::cerr << "Cannot open trajectories " << filename << std::endl;
+        return false;
+    }
+    TrajectoryHeader header;
+    if (file.size() < sizeof(header)) {
+        std::cerr << "Truncated trajectory file " << filename << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != TrajectoryWriter::VERSION) {
+        std::cerr << filename << " is not a trajectory file of version " << TrajectoryWriter::VERSION << std::endl;
+        return false;
+    }
+    width = static_cast<int>(header.width);
+    height = static_cast<int>(header.height);
+    agentCount = static_cast<int>(header.agentCount);
+    offset = sizeof(header);
+    return true;
+}
+
+bool TrajectoryReader::next(Position& start, Position& goal, CompactPath& path) {
+    if (!file.isOpen() || offset == file.size()) return false;
+
+    RecordHeader record;
+    if (file.size() - offset < sizeof(record)) {
+        std::cerr << "Truncated trajectory file " << filename << std::endl;
+        return false;
+    }
+    std::memcpy(&record, file.data() + offset, sizeof(record));
+    const size_t codesOffset = offset + sizeof(record);
+    const uint8_t* codes = reinterpret_cast<const uint8_t*>(file.data() + codesOffset);
+    if (file.size() - codesOffset < record.codeCount
+        || !path.assign({ record.startX, record.startY }, static_cast<int>(record.length), codes, record.codeCount)) {
+        std::cerr << "Damaged record in trajectory file " << filename << std::endl;
+        return false;
+    }
+    start = { record.startX, record.startY };
+    goal = { record.goalX, record.goalY };
+    offset = codesOffset + record.codeCount;
+    return true;
+}
+
+bool writeTrajectoryFile(const std::string& filename, int width, int height, const std::vector<Position>& starts,
+    const std::vector<Position>& goals, const std::vector<Path>& paths) {
+
+    TrajectoryWriter writer;
+    if (!writer.open(filename, width, height)) return false;
+    for (size_t i = 0; i < goals.size(); ++i) {
+        if (!writer.write(starts[i], goals[i], i < paths.size() ? paths[i] : Path())) {
+            std::cerr << "Path of agent " << i << " cannot be stored in " << filename << std::endl;
+            return false;
+        }
+    }
+    return writer.close();
+}
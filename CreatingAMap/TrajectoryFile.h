@@ -0,0 +1,70 @@
+#pragma once
+
+#include "MapfTypes.h"
+#include "CompactPath.h"
+#include "MappedFile.h"
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Binary file of a solved instance: a header, then one record per agent with
+// its start, its goal and its path as a CompactPath (empty for an agent
+// without a path). Records are written and read one at a time, so neither
+// side holds more than one path.
+//
+//   Header | Record... where Record = int32 goalX, goalY, startX, startY,
+//                                     uint32 length, uint32 codeCount, codes
+//
+// Numbers are stored in the machine's byte order, as in the map cache.
+struct TrajectoryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width, height;  // Of the map the paths are on
+    uint32_t agentCount;     // Filled in when the writer is closed successfully
+};
+
+class TrajectoryWriter {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    ~TrajectoryWriter() { discard(); }
+
+    bool open(const std::string& filename, int width, int height);
+    // Fails if the path has a jump between two cells.
+    bool write(const Position& start, const Position& goal, const Path& path);
+    // Writes the agent count. If a write failed, or the count cannot be
+    // written, the file is removed instead and false is returned.
+    bool close();
+    // Closes and removes the file without completing it; done by the
+    // destructor of a writer that was not closed.
+    void discard();
+
+private:
+    std::ofstream out;
+    std::string filename;
+    uint32_t agentCount = 0;
+    bool failed = false;
+};
+
+class TrajectoryReader {
+public:
+    bool open(const std::string& filename);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getAgentCount() const { return agentCount; }
+
+    // The next agent; false at the end or on a damaged record.
+    bool next(Position& start, Position& goal, CompactPath& path);
+
+private:
+    MappedFile file;
+    std::string filename;
+    int width = 0, height = 0, agentCount = 0;
+    size_t offset = 0;
+};
+
+// Writes a whole solution, agent i with starts[i], goals[i] and paths[i].
+bool writeTrajectoryFile(const std::string& filename, int width, int height, const std::vector<Position>& starts,
+    const std::vector<Position>& goals, const std::vector<Path>& paths);
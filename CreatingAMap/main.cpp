@@ -13,12 +13,29 @@
 #include <set>
 #include <tuple>
 #include <iomanip> 
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "LowLevel.h"
+#include "CBS.h"
+#include "ICTS.h"
+#include "ECBS.h"
+#include "Solvers.h"
+#include "MovingAI.h"
+#include "MapCache.h"
+#include "LifelongPlanner.h"
+#include "AgentTable.h"
+#include "ScenarioGenerator.h"
+#include "TrajectoryFile.h"
+#include "PlanExecutor.h"
 
 const int WINDOW_WIDTH = 1400;
 const int WINDOW_HEIGHT = 900;
+const int FRAME_RATE = 60; // Redraws per second, whatever the playback speed
 
 enum AppState { MENU, MAP_VIEW };
-enum Algorithm { CBS, ICTS };
 
 float calculateTileSize(int mapWidth, int mapHeight) {
     float tileWidth = static_cast<float>(WINDOW_WIDTH) / mapWidth;
@@ -26,103 +43,60 @@ float calculateTileSize(int mapWidth, int mapHeight) {
     return std::min(tileWidth, tileHeight);
 }
 
-struct Position {
-    int x, y;
-    bool operator==(const Position& other) const {
-        return x == other.x && y == other.y;
+// Agent i's colour. Hues a golden angle apart keep agents with nearby ids
+// apart however many agents there are.
+sf::Color agentColor(int agent) {
+    const float hue = std::fmod(agent * 137.508f, 360.0f) / 60.0f;
+    const float value = agent % 2 == 0 ? 0.95f : 0.75f;
+    const float chroma = value * 0.85f;
+    const float x = chroma * (1.0f - std::fabs(std::fmod(hue, 2.0f) - 1.0f));
+    float r = 0.0f, g = 0.0f, b = 0.0f;
+    switch (static_cast<int>(hue)) {
+    case 0: r = chroma; g = x; break;
+    case 1: r = x; g = chroma; break;
+    case 2: g = chroma; b = x; break;
+    case 3: g = x; b = chroma; break;
+    case 4: r = x; b = chroma; break;
+    default: r = chroma; b = x; break;
     }
-    bool operator<(const Position& other) const {
-        return std::tie(x, y) < std::tie(other.x, other.y);
-    }
-};
+    const float m = value - chroma;
+    return sf::Color(static_cast<sf::Uint8>((r + m) * 255), static_cast<sf::Uint8>((g + m) * 255),
+        static_cast<sf::Uint8>((b + m) * 255));
+}
 
-namespace std {
-    template<>
-    struct hash<Position> {
-        size_t operator()(const Position& p) const {
-            return p.x * 1812433253 + p.y;
-        }
+// Everything on the map is drawn from vertex arrays of triangles, so a frame is
+// two draw calls (tiles, then targets and agents) however large the map is or
+// however many agents it has.
+void appendRect(sf::VertexArray& vertices, float left, float top, float width, float height, sf::Color color) {
+    const sf::Vector2f corners[4] = {
+        { left, top }, { left + width, top }, { left + width, top + height }, { left, top + height }
     };
+    const int order[6] = { 0, 1, 2, 0, 2, 3 };
+    for (int i : order) vertices.append(sf::Vertex(corners[i], color));
 }
 
-struct PathNode {
-    Position pos;
-    int g, h;
-    PathNode* parent;
-
-    PathNode(Position p, int g, int h, PathNode* parent = nullptr)
-        : pos(p), g(g), h(h), parent(parent) {}
-
-    int f() const { return g + h; }
-};
-
-struct Agent {
-    sf::CircleShape shape;
-    Position currentPos;
-    Position startPos;
-    Position targetPos;
-    std::vector<Position> path;
-    size_t currentPathIndex;
-    bool reachedTarget;
-    float tileSize;
-    sf::Color color;
-    int id;
-
-    Agent(int id, Position start, Position target, float tSize, sf::Color color)
-        : id(id), startPos(start), currentPos(start), targetPos(target),
-        tileSize(tSize), color(color), reachedTarget(false), currentPathIndex(0) {
-        shape.setRadius(tileSize / 2.5f);
-        shape.setFillColor(color);
-        shape.setOutlineThickness(1);
-        shape.setOutlineColor(sf::Color::Black);
-    }
-
-    void updatePosition(float offsetX, float offsetY) {
-        shape.setPosition(offsetX + currentPos.x * tileSize + tileSize / 4,
-            offsetY + currentPos.y * tileSize + tileSize / 4);
-    }
-
-    void moveAlongPath(const std::set<Position>& occupiedTargets) {
-        if (reachedTarget || path.empty() || currentPathIndex >= path.size()) return;
-
-        Position nextPos = path[currentPathIndex];
-
-        // Eer bir sonraki pozisyon baka bir ajann hedef pozisyonuysa ve o ajan hedefine ulatysa, bekle
-        if (occupiedTargets.count(nextPos) > 0) {
-            return; // Bu turda hareket etme, bekle
-        }
-
-        currentPos = nextPos;
-        currentPathIndex++;
-
-        if (currentPos == targetPos) {
-            reachedTarget = true;
-        }
-    }
-};
-
-struct Target {
-    sf::RectangleShape shape;
-    Position pos;
-
-    Target(Position p, float tileSize) : pos(p) {
-        shape.setSize(sf::Vector2f(tileSize * 0.8f, tileSize * 0.8f));
-        shape.setFillColor(sf::Color::Magenta);
-        shape.setOutlineThickness(1);
-        shape.setOutlineColor(sf::Color::Black);
+void appendCircle(sf::VertexArray& vertices, sf::Vector2f center, float radius, sf::Color color) {
+    const int segments = 16;
+    const float step = 2.0f * 3.14159265f / segments;
+    for (int i = 0; i < segments; ++i) {
+        sf::Vector2f a(center.x + radius * std::cos(i * step), center.y + radius * std::sin(i * step));
+        sf::Vector2f b(center.x + radius * std::cos((i + 1) * step), center.y + radius * std::sin((i + 1) * step));
+        vertices.append(sf::Vertex(center, color));
+        vertices.append(sf::Vertex(a, color));
+        vertices.append(sf::Vertex(b, color));
     }
-
-    void updatePosition(float offsetX, float offsetY, float tileSize) {
-        shape.setPosition(offsetX + pos.x * tileSize + tileSize / 10,
-            offsetY + pos.y * tileSize + tileSize / 10);
-    }
-};
+}
 
 struct MapData {
-    std::vector<std::vector<bool>> collisionMap;
-    std::vector<sf::RectangleShape> tiles;
-    std::vector<Agent> agents;
-    std::vector<Target> targets;
+    Grid grid;
+    sf::VertexArray tiles;   // Static map layer, built once per map
+    sf::VertexArray markers; // Targets and agents, rebuilt when drawn
+    AgentTable agents;
+    std::vector<sf::Color> agentColors; // Render data, by agent index
+    int numAgents; // Taken from the scenario or generated
+    unsigned seed; // Of the generated agents
+    std::string replayFile;   // Saved solution shown instead of planning; empty to plan
+    std::string solutionFile; // Where planned paths are saved
     int width, height;
     float tileSize;
     sf::Vector2f offset;
@@ -131,342 +105,222 @@ struct MapData {
     bool allAgentsReached;
     float completionTime;
     Algorithm selectedAlgorithm;
+    int plannerThreads;
+    double suboptimality; // w of ECBS
+    bool independenceDetection; // CBS and ICTS solve groups of dependent agents only
     std::string mapName;
-    std::set<Position> occupiedTargets; // Yeni: Ulalm hedef pozisyonlar
+    std::unique_ptr<HeuristicCache> heuristics; // Distance tables for the agents' targets on this grid
+    MapCache mapCache; // Compiled map and persisted distance tables, next to the map file
+    bool persistTables; // Store the targets' distance tables in the map cache before planning
+
+    // Planning runs on a worker thread, which fills 'plannedAgents' and then
+    // raises 'planReady'; the main loop starts the simulation from them.
+    std::thread planner;
+    SearchControl planControl;
+    std::atomic<bool> planReady{ false };
+    bool planning;
+    AgentTable plannedAgents;
+
+    // Steps 'agents' along their paths; the main loop sets the playback speed
+    std::unique_ptr<PlanExecutor> executor;
+
+    // Lifelong mode: agents get a new target whenever they reach one and are
+    // replanned online instead of by the worker thread
+    bool lifelong;
+    std::unique_ptr<LifelongPlanner> lifelongPlanner;
+    int tasksCompleted;
+
+    ~MapData() {
+        // A search that is still running must not outlive the map it plans on
+        planControl.cancel();
+        if (planner.joinable()) planner.join();
+    }
 };
 
 // Artk kullanmyoruz, kaldryoruz
 // std::vector<std::vector<bool>> createDynamicCollisionMap(...) - REMOVED
 
-std::vector<Position> findPath(const Position& start, const Position& target,
-    const std::vector<std::vector<bool>>& collisionMap,
-    int mapWidth, int mapHeight) {
-    auto heuristic = [](const Position& a, const Position& b) {
-        return std::abs(a.x - b.x) + std::abs(a.y - b.y);
-        };
-
-    auto cmp = [](PathNode* a, PathNode* b) { return a->f() > b->f(); };
-    std::priority_queue<PathNode*, std::vector<PathNode*>, decltype(cmp)> openSet(cmp);
-    std::unordered_map<Position, PathNode*> allNodes;
-
-    PathNode* startNode = new PathNode(start, 0, heuristic(start, target));
-    openSet.push(startNode);
-    allNodes[start] = startNode;
-
-    const std::vector<Position> directions = { {1, 0}, {0, 1}, {-1, 0}, {0, -1} };
-
-    while (!openSet.empty()) {
-        PathNode* current = openSet.top();
-        openSet.pop();
-
-        if (current->pos == target) {
-            std::vector<Position> path;
-            while (current != nullptr) {
-                path.push_back(current->pos);
-                current = current->parent;
-            }
-            std::reverse(path.begin(), path.end());
-
-            for (auto& pair : allNodes) {
-                delete pair.second;
-            }
-
-            return path;
-        }
-
-        for (const auto& dir : directions) {
-            Position neighbor = { current->pos.x + dir.x, current->pos.y + dir.y };
-
-            if (neighbor.x < 0 || neighbor.x >= mapWidth ||
-                neighbor.y < 0 || neighbor.y >= mapHeight ||
-                collisionMap[neighbor.y][neighbor.x]) {
-                continue;
-            }
-
-            int newG = current->g + 1;
-            auto it = allNodes.find(neighbor);
-
-            if (it == allNodes.end() || newG < it->second->g) {
-                PathNode* neighborNode;
-                if (it == allNodes.end()) {
-                    neighborNode = new PathNode(neighbor, newG, heuristic(neighbor, target), current);
-                    allNodes[neighbor] = neighborNode;
-                    openSet.push(neighborNode);
-                }
-                else {
-                    neighborNode = it->second;
-                    neighborNode->g = newG;
-                    neighborNode->parent = current;
-                }
-            }
-        }
+// Targets as outlined squares and agents as outlined circles, at their current cells
+void buildMarkerLayer(MapData& mapData) {
+    const float tile = mapData.tileSize;
+    mapData.markers.clear();
+    mapData.markers.setPrimitiveType(sf::Triangles);
+
+    for (const Position& target : mapData.agents.getGoals()) {
+        float left = mapData.offset.x + target.x * tile + tile / 10;
+        float top = mapData.offset.y + target.y * tile + tile / 10;
+        appendRect(mapData.markers, left - 1, top - 1, tile * 0.8f + 2, tile * 0.8f + 2, sf::Color::Black);
+        appendRect(mapData.markers, left, top, tile * 0.8f, tile * 0.8f, sf::Color::Magenta);
     }
 
-    for (auto& pair : allNodes) {
-        delete pair.second;
+    const float radius = tile / 2.5f;
+    for (int i = 0; i < mapData.agents.size(); ++i) {
+        const Position position = mapData.agents.getPosition(i);
+        sf::Vector2f center(mapData.offset.x + position.x * tile + tile / 4 + radius,
+            mapData.offset.y + position.y * tile + tile / 4 + radius);
+        appendCircle(mapData.markers, center, radius + 1, sf::Color::Black);
+        appendCircle(mapData.markers, center, radius, mapData.agentColors[i]);
     }
-
-    return {};
 }
 
+std::vector<Position> findPath(const Position& start, const Position& target, const Grid& grid,
+    HeuristicCache* heuristics = nullptr) {
+    // One workspace per planning thread, reused by every query
+    static thread_local SearchWorkspace workspace;
+    std::shared_ptr<const DistanceTable> table;
+    if (heuristics && !grid.isBlocked(target)) table = heuristics->get(target);
+    return findShortestPath(start, target, grid, workspace, table.get());
+}
 
-void findPathsWithCBS(std::vector<Agent>& agents, const std::vector<std::vector<bool>>& baseCollisionMap,
-    int mapWidth, int mapHeight) {
-
-    for (auto& agent : agents) {
-        agent.path = findPath(agent.startPos, agent.targetPos, baseCollisionMap, mapWidth, mapHeight);
+// No conflict-free solution at all, show the individual shortest paths
+void setIndividualPaths(AgentTable& agents, const Grid& grid, HeuristicCache& heuristics) {
+    std::vector<Path> paths;
+    for (int i = 0; i < agents.size(); ++i) {
+        paths.push_back(findPath(agents.getStart(i), agents.getGoal(i), grid, &heuristics));
     }
+    agents.setPaths(paths);
+}
 
-    bool hasConflicts = true;
-    int maxIterations = 1000; // ICTS iin daha fazla iterasyon
-    int iteration = 0;
-
-    while (hasConflicts && iteration < maxIterations) {
-        hasConflicts = false;
-
-        for (size_t i = 0; i < agents.size(); ++i) {
-            for (size_t j = i + 1; j < agents.size(); ++j) {
-                size_t minLength = std::min(agents[i].path.size(), agents[j].path.size());
-
-                for (size_t k = 0; k < minLength; ++k) {
-                    if (agents[i].path[k] == agents[j].path[k]) {
-                        hasConflicts = true;
-
-                        auto tempCollisionMap = baseCollisionMap;
-                        for (size_t m = 0; m < agents[i].path.size(); ++m) {
-                            if (m < tempCollisionMap.size() && agents[i].path[m].x < tempCollisionMap[0].size()) {
-                                tempCollisionMap[agents[i].path[m].y][agents[i].path[m].x] = true;
-                            }
-                        }
 
-                        agents[j].path = findPath(agents[j].startPos, agents[j].targetPos,
-                            tempCollisionMap, mapWidth, mapHeight);
-                        break;
-                    }
+// Prioritized planning, the quick fallback when an optimal solver gives up
+bool findPathsWithPrioritizedPlanning(AgentTable& agents, const Grid& grid, HeuristicCache& heuristics,
+    SearchControl* control = nullptr) {
 
-                    if (k > 0 && agents[i].path[k] == agents[j].path[k - 1] &&
-                        agents[i].path[k - 1] == agents[j].path[k]) {
-                        hasConflicts = true;
+    const std::vector<Position>& starts = agents.getStarts();
+    const std::vector<Position>& goals = agents.getGoals();
 
-                        auto tempCollisionMap = baseCollisionMap;
-                        for (size_t m = 0; m < agents[i].path.size(); ++m) {
-                            if (m < tempCollisionMap.size() && agents[i].path[m].x < tempCollisionMap[0].size()) {
-                                tempCollisionMap[agents[i].path[m].y][agents[i].path[m].x] = true;
-                            }
-                        }
+    SolveOptions options;
+    options.heuristics = &heuristics;
+    options.control = control;
+    SolverResult result = solve(PP, starts, goals, grid, options);
+    std::cout << "Prioritized planning " << (result.solved ? "solved" : "failed") << " in "
+        << result.stats.runtimeSeconds << " s, orders tried: " << result.stats.highLevelExpanded
+        << ", sum of costs: " << result.sumOfCosts << std::endl;
+    if (!result.solved) return false;
 
-                        agents[j].path = findPath(agents[j].startPos, agents[j].targetPos,
-                            tempCollisionMap, mapWidth, mapHeight);
-                        break;
-                    }
-                }
+    agents.setPaths(result.paths);
+    return true;
+}
 
-                if (hasConflicts) break;
-            }
-            if (hasConflicts) break;
-        }
+void findPathsWithCBS(AgentTable& agents, const Grid& grid, HeuristicCache& heuristics,
+    int numThreads, bool independenceDetection, SearchControl* control = nullptr) {
+
+    const std::vector<Position>& starts = agents.getStarts();
+    const std::vector<Position>& goals = agents.getGoals();
+
+    SolveOptions options;
+    options.heuristics = &heuristics;
+    options.numThreads = numThreads;
+    options.control = control;
+    options.independenceDetection = independenceDetection;
+    SolverResult result = solve(CBS, starts, goals, grid, options);
+    if (isCancelled(control)) {
+        std::cout << "CBS cancelled after " << result.stats.highLevelExpanded << " CT nodes" << std::endl;
+        return;
+    }
+    std::cout << "CBS " << (result.solved ? "solved" : "failed") << " in " << result.stats.runtimeSeconds
+        << " s, CT nodes expanded: " << result.stats.highLevelExpanded
+        << ", sum of costs: " << result.sumOfCosts
+        << ", threads: " << result.stats.threads
+        << ", speedup: " << result.stats.speedup() << "x" << std::endl;
+    if (independenceDetection) {
+        std::cout << "Independent groups: " << result.stats.independentGroups
+            << ", largest group: " << result.stats.largestGroup << " agents" << std::endl;
+    }
 
-        iteration++;
+    if (!result.solved) {
+        std::cout << "Falling back to prioritized planning..." << std::endl;
+        if (findPathsWithPrioritizedPlanning(agents, grid, heuristics, control) || isCancelled(control)) return;
+    }
+    if (result.solved) {
+        agents.setPaths(result.paths);
+    }
+    else {
+        setIndividualPaths(agents, grid, heuristics);
     }
 }
 
 // ICTS Algorithm
-struct ICTSNode {
-    std::vector<int> costs;
-    int totalCost;
-
-    ICTSNode(const std::vector<int>& c) : costs(c) {
-        totalCost = 0;
-        for (int cost : costs) totalCost += cost;
-    }
-
-    bool operator<(const ICTSNode& other) const {
-        return totalCost > other.totalCost; // For min-heap
+void findPathsWithICTS(AgentTable& agents, const Grid& grid, HeuristicCache& heuristics,
+    int numThreads, bool independenceDetection, SearchControl* control = nullptr) {
+
+    const std::vector<Position>& starts = agents.getStarts();
+    const std::vector<Position>& goals = agents.getGoals();
+
+    SolveOptions options;
+    options.heuristics = &heuristics;
+    options.numThreads = numThreads;
+    options.control = control;
+    options.independenceDetection = independenceDetection;
+    SolverResult result = solve(ICTS, starts, goals, grid, options);
+    if (isCancelled(control)) {
+        std::cout << "ICTS cancelled after " << result.stats.highLevelExpanded << " ICT nodes" << std::endl;
+        return;
     }
-};
-
-bool hasConflictsInPaths(const std::vector<std::vector<Position>>& paths) {
-    size_t maxLength = 0;
-    for (const auto& path : paths) {
-        maxLength = std::max(maxLength, path.size());
+    std::cout << "ICTS " << (result.solved ? "solved" : "failed") << " in " << result.stats.runtimeSeconds
+        << " s, ICT nodes evaluated: " << result.stats.highLevelExpanded
+        << ", joint MDD nodes expanded: " << result.stats.lowLevelExpanded
+        << ", sum of costs: " << result.sumOfCosts
+        << ", threads: " << result.stats.threads
+        << ", speedup: " << result.stats.speedup() << "x" << std::endl;
+    if (independenceDetection) {
+        std::cout << "Independent groups: " << result.stats.independentGroups
+            << ", largest group: " << result.stats.largestGroup << " agents" << std::endl;
     }
 
-    // Check vertex conflicts and edge conflicts
-    for (size_t t = 0; t < maxLength; ++t) {
-        std::set<Position> occupiedPositions;
-
-        for (size_t i = 0; i < paths.size(); ++i) {
-            Position currentPos;
-            if (t < paths[i].size()) {
-                currentPos = paths[i][t];
-            }
-            else if (!paths[i].empty()) {
-                currentPos = paths[i].back(); // Agent stays at goal
-            }
-            else {
-                continue;
-            }
-
-            // Check vertex conflict
-            if (occupiedPositions.count(currentPos)) {
-                return true;
-            }
-            occupiedPositions.insert(currentPos);
-
-            // Check edge conflict
-            if (t > 0) {
-                Position prevPos;
-                if (t - 1 < paths[i].size()) {
-                    prevPos = paths[i][t - 1];
-                }
-                else if (!paths[i].empty()) {
-                    prevPos = paths[i].back();
-                }
-                else {
-                    continue;
-                }
-
-                for (size_t j = 0; j < paths.size(); ++j) {
-                    if (i == j) continue;
-
-                    Position otherCurrent, otherPrev;
-                    if (t < paths[j].size()) {
-                        otherCurrent = paths[j][t];
-                    }
-                    else if (!paths[j].empty()) {
-                        otherCurrent = paths[j].back();
-                    }
-                    else {
-                        continue;
-                    }
-
-                    if (t - 1 < paths[j].size()) {
-                        otherPrev = paths[j][t - 1];
-                    }
-                    else if (!paths[j].empty()) {
-                        otherPrev = paths[j].back();
-                    }
-                    else {
-                        continue;
-                    }
-
-                    // Edge conflict: agents swap positions
-                    if (currentPos == otherPrev && prevPos == otherCurrent) {
-                        return true;
-                    }
-                }
-            }
+    if (!result.solved) {
+        std::cout << "Falling back to prioritized planning..." << std::endl;
+        if (!findPathsWithPrioritizedPlanning(agents, grid, heuristics, control)) {
+            setIndividualPaths(agents, grid, heuristics);
         }
+        return;
     }
-
-    return false;
+    agents.setPaths(result.paths);
 }
 
-std::vector<Position> findPathWithMaxCost(const Position& start, const Position& target,
-    const std::vector<std::vector<bool>>& collisionMap,
-    int mapWidth, int mapHeight, int maxCost) {
-
-    // Eer maxCost ok kkse, minimum path'i dndr
-    auto minPath = findPath(start, target, collisionMap, mapWidth, mapHeight);
-    if (minPath.empty()) return {};
-
-    int minCost = minPath.size() - 1;
-    if (maxCost < minCost) return {}; // mkansz
-    if (maxCost == minCost) return minPath; // Tam uyuyor
-
-    // maxCost > minCost ise, path'i uzatmaya al
-    auto extendedPath = minPath;
-    int extraSteps = maxCost - minCost;
-
-    // Basit uzatma: son pozisyonda kal
-    for (int i = 0; i < extraSteps; i++) {
-        extendedPath.push_back(target);
+// ECBS: bounded-suboptimal, the sum of costs is at most w times the optimum
+void findPathsWithECBS(AgentTable& agents, const Grid& grid, HeuristicCache& heuristics,
+    double suboptimality, SearchControl* control = nullptr) {
+
+    const std::vector<Position>& starts = agents.getStarts();
+    const std::vector<Position>& goals = agents.getGoals();
+
+    ECBSOptions options;
+    options.heuristics = &heuristics;
+    options.suboptimality = suboptimality;
+    options.control = control;
+    SolverResult result = solveECBS(starts, goals, grid, options);
+    if (isCancelled(control)) {
+        std::cout << "ECBS cancelled after " << result.stats.highLevelExpanded << " CT nodes" << std::endl;
+        return;
     }
-
-    return extendedPath;
-}
-
-void findPathsWithICTS(std::vector<Agent>& agents, const std::vector<std::vector<bool>>& baseCollisionMap,
-    int mapWidth, int mapHeight) {
-
-    // Find minimum individual costs
-    std::vector<int> minCosts(agents.size());
-    for (size_t i = 0; i < agents.size(); ++i) {
-        auto path = findPath(agents[i].startPos, agents[i].targetPos, baseCollisionMap, mapWidth, mapHeight);
-        minCosts[i] = path.empty() ? 0 : path.size() - 1;
-        std::cout << "Agent " << i << " min cost: " << minCosts[i] << std::endl; // Debug
+    std::cout << "ECBS (w = " << suboptimality << ") " << (result.solved ? "solved" : "failed")
+        << " in " << result.stats.runtimeSeconds
+        << " s, CT nodes expanded: " << result.stats.highLevelExpanded
+        << ", sum of costs: " << result.sumOfCosts
+        << ", lower bound: " << result.lowerBound << std::endl;
+
+    if (!result.solved) {
+        std::cout << "Falling back to prioritized planning..." << std::endl;
+        if (findPathsWithPrioritizedPlanning(agents, grid, heuristics, control) || isCancelled(control)) return;
     }
-
-    std::priority_queue<ICTSNode> queue;
-    queue.push(ICTSNode(minCosts));
-
-    int maxIterations = 100;
-    int iteration = 0;
-
-    std::cout << "Starting ICTS iterations..." << std::endl; // Debug
-
-    while (!queue.empty() && iteration < maxIterations) {
-        ICTSNode current = queue.top();
-        queue.pop();
-        iteration++;
-
-        std::cout << "ICTS iteration " << iteration << ", total cost: " << current.totalCost << std::endl; // Debug
-
-        // Generate paths with current costs
-        std::vector<std::vector<Position>> paths(agents.size());
-        bool allPathsFound = true;
-
-        for (size_t i = 0; i < agents.size(); ++i) {
-            paths[i] = findPathWithMaxCost(agents[i].startPos, agents[i].targetPos,
-                baseCollisionMap, mapWidth, mapHeight, current.costs[i]);
-            if (paths[i].empty()) {
-                std::cout << "Failed to find path for agent " << i << " with cost " << current.costs[i] << std::endl; // Debug
-                allPathsFound = false;
-                break;
-            }
-        }
-
-        if (!allPathsFound) {
-            std::cout << "Not all paths found, continuing..." << std::endl; // Debug
-            continue;
-        }
-
-        // Check for conflicts
-        if (!hasConflictsInPaths(paths)) {
-            // Solution found!
-            std::cout << "ICTS solution found after " << iteration << " iterations!" << std::endl; // Debug
-            for (size_t i = 0; i < agents.size(); ++i) {
-                agents[i].path = paths[i];
-                std::cout << "Agent " << i << " path length: " << agents[i].path.size() << std::endl; // Debug
-            }
-            return;
-        }
-
-        std::cout << "Conflicts found, generating child nodes..." << std::endl; // Debug
-
-        // Generate child nodes by increasing costs
-        for (size_t i = 0; i < current.costs.size(); ++i) {
-            auto newCosts = current.costs;
-            newCosts[i]++;
-            queue.push(ICTSNode(newCosts));
-        }
+    if (result.solved) {
+        agents.setPaths(result.paths);
+    }
+    else {
+        setIndividualPaths(agents, grid, heuristics);
     }
-
-    std::cout << "ICTS failed after " << maxIterations << " iterations, falling back to CBS..." << std::endl; // Debug
-
-    // Fallback to CBS if ICTS fails - FIX: Correct parameters
-    findPathsWithCBS(agents, baseCollisionMap, mapWidth, mapHeight);
 }
 
 // Agent pozisyonlarn dosyaya kaydet
-void saveAgentPositions(const std::string& filename, const std::vector<Agent>& agents) {
+void saveAgentPositions(const std::string& filename, const AgentTable& agents) {
     std::ofstream file(filename);
     if (file.is_open()) {
         file << agents.size() << std::endl;
-        for (const auto& agent : agents) {
-            file << agent.id << " "
-                << agent.startPos.x << " " << agent.startPos.y << " "
-                << agent.targetPos.x << " " << agent.targetPos.y << std::endl;
+        for (int i = 0; i < agents.size(); ++i) {
+            file << i << " "
+                << agents.getStart(i).x << " " << agents.getStart(i).y << " "
+                << agents.getGoal(i).x << " " << agents.getGoal(i).y << std::endl;
         }
         file.close();
         std::cout << "Agent positions saved to " << filename << std::endl;
@@ -474,8 +328,8 @@ void saveAgentPositions(const std::string& filename, const std::vector<Agent>& a
 }
 
 // Agent pozisyonlarn dosyadan ykle
-bool loadAgentPositions(const std::string& filename, std::vector<Agent>& agents,
-    const std::vector<sf::Color>& agentColors, float tileSize) {
+// Only used if the file has 'count' agents
+bool loadAgentPositions(const std::string& filename, AgentTable& agents, int count) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         return false;
@@ -483,8 +337,12 @@ bool loadAgentPositions(const std::string& filename, std::vector<Agent>& agents,
 
     int numAgents;
     file >> numAgents;
+    if (!file || numAgents != count) {
+        return false;
+    }
 
     agents.clear();
+    agents.reserve(numAgents);
     for (int i = 0; i < numAgents; i++) {
         int id, startX, startY, targetX, targetY;
         file >> id >> startX >> startY >> targetX >> targetY;
@@ -492,7 +350,7 @@ bool loadAgentPositions(const std::string& filename, std::vector<Agent>& agents,
         Position start = { startX, startY };
         Position target = { targetX, targetY };
 
-        agents.emplace_back(id, start, target, tileSize, agentColors[id % agentColors.size()]);
+        agents.add(start, target);
     }
 
     file.close();
@@ -500,163 +358,411 @@ bool loadAgentPositions(const std::string& filename, std::vector<Agent>& agents,
     return true;
 }
 
-void saveResultToFile(const std::string& mapName, Algorithm algorithm, float completionTime, int numAgents) {
+// Take the first 'count' agents of a MovingAI scenario file
+bool loadAgentScenario(const std::string& filename, AgentTable& agents, int count) {
+    ScenarioFile scenario;
+    std::ifstream probe(filename);
+    if (!probe.is_open() || !scenario.open(filename)) {
+        return false;
+    }
+
+    std::vector<ScenarioEntry> entries;
+    if (!scenario.getEntries(count, entries) || entries.empty()) {
+        return false;
+    }
+
+    agents.clear();
+    agents.reserve(static_cast<int>(entries.size()));
+    for (const ScenarioEntry& entry : entries) {
+        agents.add(entry.start, entry.goal);
+    }
+    std::cout << "Agents loaded from scenario " << filename << std::endl;
+    return true;
+}
+
+// Stores the planned paths, so the run can be replayed without the planner
+void saveSolution(const std::string& filename, const AgentTable& agents, const Grid& grid) {
+    std::vector<Path> paths;
+    for (int i = 0; i < agents.size(); ++i) {
+        paths.emplace_back(agents.getPath(i), agents.getPath(i) + agents.getPathLength(i));
+    }
+    if (writeTrajectoryFile(filename, grid.getWidth(), grid.getHeight(), agents.getStarts(), agents.getGoals(), paths)) {
+        std::cout << "Solution saved to " << filename << std::endl;
+    }
+}
+
+// Agents and paths of a saved solution; only used if it was made on a map of this size
+bool loadSolution(const std::string& filename, AgentTable& agents, const Grid& grid) {
+    TrajectoryReader reader;
+    if (!reader.open(filename)) return false;
+    if (reader.getWidth() != grid.getWidth() || reader.getHeight() != grid.getHeight()) {
+        std::cerr << filename << " was saved on a " << reader.getWidth() << "x" << reader.getHeight() << " map" << std::endl;
+        return false;
+    }
+
+    agents.clear();
+    agents.reserve(reader.getAgentCount());
+    std::vector<Path> paths;
+    Position start, goal;
+    CompactPath path;
+    while (reader.next(start, goal, path)) {
+        agents.add(start, goal);
+        paths.push_back(path.decode());
+    }
+    if (agents.size() != reader.getAgentCount()) {
+        agents.clear();
+        return false;
+    }
+    agents.setPaths(paths);
+    std::cout << "Solution of " << agents.size() << " agents loaded from " << filename << std::endl;
+    return true;
+}
+
+// Executes the agents' paths from their starts
+void startExecution(MapData& mapData) {
+    mapData.executor.reset(new PlanExecutor(mapData.grid, mapData.agents));
+    mapData.planning = false;
+    mapData.simulationRunning = true;
+    mapData.timer.restart();
+}
+
+void saveResultToFile(const std::string& mapName, Algorithm algorithm, float completionTime, int numAgents,
+    const ExecutionMetrics& metrics) {
     std::ofstream file("simulation_results.txt", std::ios::app);
     if (file.is_open()) {
-        std::string algName = (algorithm == CBS) ? "CBS" : "ICTS";
+        std::string algName = algorithmName(algorithm);
         file << std::fixed << std::setprecision(4);
-        file << mapName << "," << algName << "," << completionTime << "," << numAgents << std::endl;
+        file << mapName << "," << algName << "," << completionTime << "," << numAgents << ","
+            << metrics.timesteps << "," << metrics.sumOfCosts << "," << metrics.waits << std::endl;
         file.close();
         std::cout << "Result saved: " << mapName << " - " << algName << " - " << completionTime << "s" << std::endl;
     }
 }
 
+const char* const RESULTS_HEADER = "MapName,Algorithm,CompletionTime,NumAgents,Makespan,SumOfCosts,Waits";
+const char* const OLD_RESULTS_HEADER = "MapName,Algorithm,CompletionTime,NumAgents";
+
+// Results written before the step metrics existed get empty Makespan,
+// SumOfCosts and Waits fields, so every row has the columns of the header
+bool migrateResultsFile(std::ifstream& checkFile) {
+    std::vector<std::string> rows;
+    std::string line;
+    while (std::getline(checkFile, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) rows.push_back(line);
+    }
+    checkFile.close();
+
+    std::ofstream file("simulation_results.txt", std::ios::trunc);
+    if (!file.is_open()) return false;
+    file << RESULTS_HEADER << std::endl;
+    for (const auto& row : rows) {
+        file << row << ",,," << std::endl;
+    }
+    return true;
+}
+
 void initializeResultsFile() {
     // Check if file already exists
     std::ifstream checkFile("simulation_results.txt");
     bool fileExists = checkFile.good();
-    checkFile.close();
+    std::string header;
+    if (fileExists) std::getline(checkFile, header);
+    if (!header.empty() && header.back() == '\r') header.pop_back();
 
     if (!fileExists) {
         // Only create header if file doesn't exist
+        checkFile.close();
         std::ofstream file("simulation_results.txt");
         if (file.is_open()) {
-            file << "MapName,Algorithm,CompletionTime,NumAgents" << std::endl;
+            file << RESULTS_HEADER << std::endl;
             file.close();
             std::cout << "Results file initialized with headers." << std::endl;
         }
     }
+    else if (header == OLD_RESULTS_HEADER) {
+        if (migrateResultsFile(checkFile)) {
+            std::cout << "Results file migrated to the Makespan, SumOfCosts and Waits columns." << std::endl;
+        }
+    }
     else {
         std::cout << "Results file already exists, appending new results..." << std::endl;
     }
 }
 
+// Stores the targets' distance tables in the map cache, so the next run with
+// the same targets starts with them, and plans with the mapped tables. Runs on
+// the planner thread: on a large map this computes and writes about a megabyte
+// per target.
+void persistTargetTables(MapData& mapData) {
+    if (!mapData.mapCache.isOpen()) return;
+    std::vector<int> goalCells;
+    for (const Position& goal : mapData.agents.getGoals()) {
+        goalCells.push_back(mapData.grid.toId(goal));
+    }
+    // Computed tables go straight to the file and are planned with from there
+    HeuristicCache builder(mapData.grid, 0);
+    if (mapData.mapCache.storeTables(goalCells, builder, &mapData.planControl)) {
+        mapData.mapCache.preloadTables(*mapData.heuristics);
+    }
+}
+
 bool loadMapFromFile(const std::string& filename, MapData& mapData) {
-    std::ifstream file(filename);
-    if (!file.is_open()) return false;
+    // The binary cache is rebuilt from the text map when that is newer
+    std::vector<char> terrain;
+    if (mapData.mapCache.open(filename)) {
+        mapData.mapCache.loadGrid(mapData.grid, &terrain);
+    }
+    else if (!loadGridFile(filename, mapData.grid, &terrain)) {
+        return false;
+    }
+
+    // The map size comes from the file itself
+    mapData.width = mapData.grid.getWidth();
+    mapData.height = mapData.grid.getHeight();
+    mapData.tileSize = calculateTileSize(mapData.width, mapData.height);
+    mapData.offset = sf::Vector2f(
+        (WINDOW_WIDTH - mapData.width * mapData.tileSize) / 2.0f,
+        (WINDOW_HEIGHT - mapData.height * mapData.tileSize) / 2.0f
+    );
 
-    mapData.collisionMap = std::vector<std::vector<bool>>(mapData.height, std::vector<bool>(mapData.width, false));
     mapData.tiles.clear();
     mapData.agents.clear();
-    mapData.targets.clear();
-    mapData.occupiedTargets.clear(); // Yeni: Ulalm hedefleri temizle
 
     size_t lastSlash = filename.find_last_of("/\\");
     size_t lastDot = filename.find_last_of(".");
     mapData.mapName = filename.substr(lastSlash + 1, lastDot - lastSlash - 1);
 
-    std::string line;
-    int y = 0;
-    while (std::getline(file, line) && y < mapData.height) {
-        for (int x = 0; x < line.size() && x < mapData.width; ++x) {
-            char c = line[x];
-            sf::RectangleShape tile(sf::Vector2f(mapData.tileSize, mapData.tileSize));
-            tile.setPosition(mapData.offset.x + x * mapData.tileSize, mapData.offset.y + y * mapData.tileSize);
-            if (c == '@') {
-                tile.setFillColor(sf::Color::Black);
-                mapData.collisionMap[y][x] = true;
-            }
-            else if (c == 'T') {
-                tile.setFillColor(sf::Color::Green);
-                mapData.collisionMap[y][x] = true;
+    // Runs of equally coloured tiles in a row become one rectangle
+    mapData.tiles.setPrimitiveType(sf::Triangles);
+    for (int y = 0; y < mapData.height; ++y) {
+        int runStart = 0;
+        sf::Color runColor;
+        for (int x = 0; x <= mapData.width; ++x) {
+            sf::Color color;
+            if (x < mapData.width) {
+                char c = terrain[static_cast<size_t>(y) * mapData.width + x];
+                if (c == 'T') {
+                    color = sf::Color::Green;
+                }
+                else if (mapData.grid.isBlocked(Position{ x, y })) {
+                    color = sf::Color::Black;
+                }
+                else {
+                    color = sf::Color::White;
+                }
+                if (x == 0) runColor = color;
             }
-            else {
-                tile.setFillColor(sf::Color::White);
-                mapData.collisionMap[y][x] = false;
+            if (x == mapData.width || color != runColor) {
+                appendRect(mapData.tiles, mapData.offset.x + runStart * mapData.tileSize,
+                    mapData.offset.y + y * mapData.tileSize,
+                    (x - runStart) * mapData.tileSize, mapData.tileSize, runColor);
+                runStart = x;
+                runColor = color;
             }
-
-            mapData.tiles.push_back(tile);
         }
-        ++y;
     }
 
-    while (y < mapData.height) {
-        for (int x = 0; x < mapData.width; ++x) {
-            sf::RectangleShape tile(sf::Vector2f(mapData.tileSize, mapData.tileSize));
-            tile.setPosition(mapData.offset.x + x * mapData.tileSize, mapData.offset.y + y * mapData.tileSize);
-            tile.setFillColor(sf::Color::White);
-            mapData.tiles.push_back(tile);
-        }
-        ++y;
-    }
+    mapData.heuristics.reset(new HeuristicCache(mapData.grid));
 
-    std::vector<sf::Color> agentColors = {
-        sf::Color::Red, sf::Color::Green, sf::Color::Blue, sf::Color::Yellow,
-        sf::Color::Cyan, sf::Color::Magenta, sf::Color(255, 165, 0),
-        sf::Color(128, 0, 128), sf::Color(0, 128, 0), sf::Color(128, 128, 0)
-    };
+    // Agents come from a MovingAI scenario next to the map, else from the saved positions
+    std::string basePath = filename.substr(0, filename.find_last_of('.'));
+    std::string positionsFile = basePath + "_positions.txt";
+    mapData.solutionFile = basePath + "_solution.traj";
 
-    // Agent pozisyonlarn yklemeye al
-    std::string positionsFile = filename.substr(0, filename.find_last_of('.')) + "_positions.txt";
+    // A saved solution brings its own agents and paths
+    const bool replay = !mapData.replayFile.empty() && loadSolution(mapData.replayFile, mapData.agents, mapData.grid);
 
-    if (!loadAgentPositions(positionsFile, mapData.agents, agentColors, mapData.tileSize)) {
-        // Pozisyonlar dosyas yoksa yeni pozisyonlar olutur
+    if (!replay && !loadAgentScenario(basePath + ".scen", mapData.agents, mapData.numAgents) &&
+        !loadAgentPositions(positionsFile, mapData.agents, mapData.numAgents)) {
         std::cout << "No saved positions found, generating new positions..." << std::endl;
 
-        for (int i = 0; i < 5; ++i) {
-            Position start, target;
-            int attempts = 0;
-
-            do {
-                start = { std::rand() % mapData.width, std::rand() % mapData.height };
-                attempts++;
-                if (attempts > 1000) break;
-            } while (mapData.collisionMap[start.y][start.x]);
-
-            attempts = 0;
-            do {
-                target = { std::rand() % mapData.width, std::rand() % mapData.height };
-                attempts++;
-                if (attempts > 1000) break;
-            } while (mapData.collisionMap[target.y][target.x] ||
-                (start.x == target.x && start.y == target.y));
-
-            if (attempts <= 1000) {
-                mapData.agents.emplace_back(i, start, target, mapData.tileSize, agentColors[i]);
-            }
+        // Starts and targets on distinct free cells, each target in its start's component
+        ScenarioGenerator generator(mapData.grid);
+        std::vector<ScenarioEntry> entries;
+        const int count = std::min(mapData.numAgents, generator.getCapacity());
+        generator.generate(mapData.seed, count, entries);
+        std::cout << "Generated " << entries.size() << " agents with seed " << mapData.seed << std::endl;
+        mapData.agents.reserve(static_cast<int>(entries.size()));
+        for (const auto& entry : entries) {
+            mapData.agents.add(entry.start, entry.goal);
         }
 
-        // Yeni oluturulan pozisyonlar kaydet
         saveAgentPositions(positionsFile, mapData.agents);
     }
 
-    // Target'lar olutur
-    for (const auto& agent : mapData.agents) {
-        mapData.targets.emplace_back(agent.targetPos, mapData.tileSize);
+    // Loaded agents may have no way to their targets; the planners would fail on them
+    for (int agent : findUnreachableAgents(mapData.agents.getStarts(), mapData.agents.getGoals(), mapData.grid)) {
+        std::cout << "Agent " << agent << " cannot reach its target" << std::endl;
     }
 
-    // Use selected algorithm
-    if (mapData.selectedAlgorithm == CBS) {
-        std::cout << "Running CBS algorithm..." << std::endl;
-        findPathsWithCBS(mapData.agents, mapData.collisionMap, mapData.width, mapData.height);
-    }
-    else {
-        std::cout << "Running ICTS algorithm..." << std::endl;
-        findPathsWithICTS(mapData.agents, mapData.collisionMap, mapData.width, mapData.height);
+    mapData.agentColors.clear();
+    for (int i = 0; i < mapData.agents.size(); ++i) {
+        mapData.agentColors.push_back(agentColor(i));
     }
 
-    for (auto& agent : mapData.agents) {
-        agent.updatePosition(mapData.offset.x, mapData.offset.y);
+    mapData.simulationRunning = false;
+    mapData.allAgentsReached = false;
+    mapData.completionTime = 0.0f;
+
+    if (replay) {
+        startExecution(mapData);
+        return true;
     }
 
-    for (auto& target : mapData.targets) {
-        target.updatePosition(mapData.offset.x, mapData.offset.y, mapData.tileSize);
+    if (mapData.lifelong) {
+        mapData.lifelongPlanner.reset(new LifelongPlanner(mapData.grid, *mapData.heuristics));
+        mapData.lifelongPlanner->reset(mapData.agents.getStarts());
+        for (int i = 0; i < mapData.agents.size(); ++i) {
+            mapData.lifelongPlanner->assignGoal(i, mapData.agents.getGoal(i));
+        }
+        mapData.tasksCompleted = 0;
+        mapData.planning = false;
+        mapData.simulationRunning = true;
+        mapData.timer.restart();
+        return true;
     }
 
-    mapData.simulationRunning = true;
-    mapData.allAgentsReached = false;
-    mapData.completionTime = 0.0f;
-    mapData.timer.restart();
+    // Plan in the background; the window keeps drawing and the search can be cancelled
+    mapData.plannedAgents = mapData.agents;
+    mapData.planning = true;
+    mapData.planner = std::thread([&mapData]() {
+        if (mapData.persistTables) persistTargetTables(mapData);
+        if (mapData.selectedAlgorithm == CBS) {
+            std::cout << "Running CBS algorithm..." << std::endl;
+            findPathsWithCBS(mapData.plannedAgents, mapData.grid, *mapData.heuristics, mapData.plannerThreads,
+                mapData.independenceDetection, &mapData.planControl);
+        }
+        else if (mapData.selectedAlgorithm == ECBS) {
+            std::cout << "Running ECBS algorithm..." << std::endl;
+            findPathsWithECBS(mapData.plannedAgents, mapData.grid, *mapData.heuristics, mapData.suboptimality,
+                &mapData.planControl);
+        }
+        else {
+            std::cout << "Running ICTS algorithm..." << std::endl;
+            findPathsWithICTS(mapData.plannedAgents, mapData.grid, *mapData.heuristics, mapData.plannerThreads,
+                mapData.independenceDetection, &mapData.planControl);
+        }
+        mapData.planReady = true;
+        });
 
     return true;
 }
 
+// A free cell reachable from 'from' that is nobody's target yet
+Position randomTarget(const MapData& mapData, const Position& from) {
+    const Grid& grid = mapData.grid;
+    Position target = from;
+    for (int attempts = 0; attempts < 1000; ++attempts) {
+        Position candidate = { std::rand() % mapData.width, std::rand() % mapData.height };
+        if (grid.isBlocked(candidate) || candidate == from) continue;
+        if (grid.getComponent(grid.toId(candidate)) != grid.getComponent(grid.toId(from))) continue;
+        const auto& goals = mapData.agents.getGoals();
+        if (std::find(goals.begin(), goals.end(), candidate) == goals.end()) return candidate;
+        target = candidate;
+    }
+    return target;
+}
+
+// One timestep of lifelong mode: agents at their targets get new ones, the
+// planner replans when it has to, and everyone moves one step.
+void stepLifelong(MapData& mapData) {
+    LifelongPlanner& planner = *mapData.lifelongPlanner;
+    AgentTable& agents = mapData.agents;
+    const int numAgents = agents.size();
+    for (int i = 0; i < numAgents; ++i) {
+        if (!planner.isIdle(i) || agents.getPosition(i) != agents.getGoal(i)) continue;
+        mapData.tasksCompleted++;
+        agents.setGoal(i, randomTarget(mapData, agents.getPosition(i)));
+        planner.assignGoal(i, agents.getGoal(i));
+    }
+
+    if (planner.needsReplan()) planner.replan();
+    planner.step();
+    for (int i = 0; i < numAgents; ++i) {
+        agents.setPosition(i, planner.getPosition(i));
+    }
+}
+
+// Last, mean and worst replan latency in milliseconds.
+void replanLatency(const LifelongPlanner& planner, double& last, double& mean, double& worst) {
+    last = mean = worst = 0.0;
+    const auto& history = planner.getHistory();
+    if (history.empty()) return;
+    for (const auto& record : history) {
+        mean += record.latencySeconds;
+        worst = std::max(worst, record.latencySeconds);
+    }
+    last = history.back().latencySeconds * 1000.0;
+    mean = mean * 1000.0 / history.size();
+    worst *= 1000.0;
+}
+
+void printLifelongSummary(const MapData& mapData) {
+    const LifelongPlanner& planner = *mapData.lifelongPlanner;
+    double last, mean, worst;
+    replanLatency(planner, last, mean, worst);
+    int replannedAgents = 0;
+    for (const auto& record : planner.getHistory()) replannedAgents += record.replannedAgents;
+    std::cout << std::fixed << std::setprecision(2)
+        << "Lifelong: " << planner.getTimestep() << " timesteps, " << mapData.tasksCompleted << " tasks, "
+        << planner.getHistory().size() << " replans (" << replannedAgents << " agent replans), latency mean "
+        << mean << " ms, max " << worst << " ms" << std::endl;
+}
 
+int main(int argc, char* argv[]) {
+    // Command line: --threads N sets the number of CBS worker threads,
+    // --w W the suboptimality factor of ECBS, --no-id plans all agents of CBS
+    // and ICTS jointly instead of per independent group, --lifelong gives the
+    // agents a new target whenever they reach one and replans them online,
+    // --agents N sets how many agents are taken from the scenario or generated,
+    // --seed N makes the generated agents and lifelong targets reproducible,
+    // --replay FILE shows a solution saved by an earlier run instead of planning,
+    // --speed N plays the paths at N timesteps per second,
+    // --persist-tables keeps the targets' distance tables in the map cache
+    int plannerThreads = 1;
+    double suboptimality = 1.2;
+    bool independenceDetection = true;
+    bool lifelong = false;
+    bool persistTables = false;
+    int numAgents = 5;
+    unsigned seed = static_cast<unsigned>(std::time(nullptr));
+    std::string replayFile;
+    int stepsPerSecond = 10;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--no-id") {
+            independenceDetection = false;
+        }
+        else if (std::string(argv[i]) == "--lifelong") {
+            lifelong = true;
+        }
+        else if (std::string(argv[i]) == "--persist-tables") {
+            persistTables = true;
+        }
+        else if (std::string(argv[i]) == "--agents" && i + 1 < argc) {
+            numAgents = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::string(argv[i]) == "--speed" && i + 1 < argc) {
+            stepsPerSecond = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::string(argv[i]) == "--replay" && i + 1 < argc) {
+            replayFile = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--seed" && i + 1 < argc) {
+            seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::string(argv[i]) == "--threads" && i + 1 < argc) {
+            plannerThreads = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::string(argv[i]) == "--w" && i + 1 < argc) {
+            suboptimality = std::max(1.0, std::atof(argv[++i]));
+        }
+    }
+    std::srand(seed);
 
-int main() {
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
     initializeResultsFile();
-    sf::RenderWindow window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "CBS & ICTS Multi-Agent Simulation");
+    sf::RenderWindow window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "CBS, ICTS & ECBS Multi-Agent Simulation");
+    window.setFramerateLimit(FRAME_RATE);
     AppState state = MENU;
     Algorithm selectedAlgorithm = CBS;
 
@@ -725,6 +831,12 @@ int main() {
     ictsBtn.setOutlineThickness(2.f);
     ictsBtn.setOutlineColor(sf::Color::White);
 
+    sf::RectangleShape ecbsBtn(sf::Vector2f(120.f, 50.f));
+    ecbsBtn.setPosition(200.f, 440.f);
+    ecbsBtn.setFillColor(sf::Color(70, 70, 70));
+    ecbsBtn.setOutlineThickness(2.f);
+    ecbsBtn.setOutlineColor(sf::Color::White);
+
     // UI elemanlar
     sf::Text title("Choose Algorithm and Map", font, 50);
     title.setPosition(WINDOW_WIDTH / 2 - title.getLocalBounds().width / 2, 50);
@@ -742,6 +854,10 @@ int main() {
     ictsText.setPosition(235.f, 385.f);
     ictsText.setFillColor(sf::Color::White);
 
+    sf::Text ecbsText("ECBS", font, 20);
+    ecbsText.setPosition(232.f, 455.f);
+    ecbsText.setFillColor(sf::Color::White);
+
     sf::Text map1Btn("Map 1", font, 20);
     sf::Text map2Btn("Map 2", font, 20);
     sf::Text map3Btn("Map 3", font, 20);
@@ -759,7 +875,10 @@ int main() {
     backBtn.setFillColor(sf::Color::Yellow);
 
     std::unique_ptr<MapData> currentMap;
+    // Timesteps fall due at the playback speed, independently of the frame rate
     sf::Clock clock;
+    const sf::Time stepInterval = sf::microseconds(std::max(1, 1000000 / stepsPerSecond));
+    sf::Time stepTime;
     sf::Text timerText("", font, 24);
     timerText.setPosition(20, 60);
     timerText.setFillColor(sf::Color::White);
@@ -782,40 +901,48 @@ int main() {
                         selectedAlgorithm = CBS;
                         cbsBtn.setFillColor(sf::Color::Green);
                         ictsBtn.setFillColor(sf::Color(70, 70, 70));
+                        ecbsBtn.setFillColor(sf::Color(70, 70, 70));
                     }
                     else if (ictsBtn.getGlobalBounds().contains(mousePos.x, mousePos.y)) {
                         selectedAlgorithm = ICTS;
                         ictsBtn.setFillColor(sf::Color::Green);
                         cbsBtn.setFillColor(sf::Color(70, 70, 70));
+                        ecbsBtn.setFillColor(sf::Color(70, 70, 70));
+                    }
+                    else if (ecbsBtn.getGlobalBounds().contains(mousePos.x, mousePos.y)) {
+                        selectedAlgorithm = ECBS;
+                        ecbsBtn.setFillColor(sf::Color::Green);
+                        cbsBtn.setFillColor(sf::Color(70, 70, 70));
+                        ictsBtn.setFillColor(sf::Color(70, 70, 70));
                     }
 
                    
                     std::string filename;
-                    int width = 0, height = 0;
 
                     if (map1Sprite.getGlobalBounds().contains(mousePos.x, mousePos.y) ||
                         map1Btn.getGlobalBounds().contains(mousePos.x, mousePos.y)) {
-                        filename = "map.txt"; width = 256; height = 257;  
+                        filename = "map.txt";
                     }
                     else if (map2Sprite.getGlobalBounds().contains(mousePos.x, mousePos.y) ||
                         map2Btn.getGlobalBounds().contains(mousePos.x, mousePos.y)) {
-                        filename = "map2.txt"; width = 194; height = 194;   
+                        filename = "map2.txt";
                     }
                     else if (map3Sprite.getGlobalBounds().contains(mousePos.x, mousePos.y) ||
                         map3Btn.getGlobalBounds().contains(mousePos.x, mousePos.y)) {
-                        filename = "map3.txt"; width = 530; height = 481;
+                        filename = "map3.txt";
                     }
 
                     if (!filename.empty()) {
                         currentMap = std::make_unique<MapData>();
-                        currentMap->width = width;
-                        currentMap->height = height;
-                        currentMap->tileSize = calculateTileSize(width, height);
                         currentMap->selectedAlgorithm = selectedAlgorithm;
-                        currentMap->offset = sf::Vector2f(
-                            (WINDOW_WIDTH - width * currentMap->tileSize) / 2.0f,
-                            (WINDOW_HEIGHT - height * currentMap->tileSize) / 2.0f
-                        );
+                        currentMap->plannerThreads = plannerThreads;
+                        currentMap->suboptimality = suboptimality;
+                        currentMap->independenceDetection = independenceDetection;
+                        currentMap->lifelong = lifelong;
+                        currentMap->persistTables = persistTables;
+                        currentMap->numAgents = numAgents;
+                        currentMap->seed = seed;
+                        currentMap->replayFile = replayFile;
                         if (loadMapFromFile(filename, *currentMap)) {
                             state = MAP_VIEW;
                         }
@@ -823,41 +950,53 @@ int main() {
                 }
                 else if (state == MAP_VIEW) {
                     if (backBtn.getGlobalBounds().contains(mousePos.x, mousePos.y)) {
+                        // Stops a search that is still running; the worker exits on its own
+                        currentMap->planControl.cancel();
+                        if (currentMap->lifelong) printLifelongSummary(*currentMap);
                         state = MENU;
                     }
                 }
             }
         }
 
-        if (clock.getElapsedTime().asMilliseconds() < 100) continue;
-        clock.restart();
-
-        if (state == MAP_VIEW && currentMap && currentMap->simulationRunning) {
-            bool allReached = true;
+        // Start the simulation as soon as the worker has the paths
+        if (state == MAP_VIEW && currentMap && currentMap->planning && currentMap->planReady) {
+            currentMap->planner.join();
+            currentMap->agents = currentMap->plannedAgents;
+            saveSolution(currentMap->solutionFile, currentMap->agents, currentMap->grid);
+            startExecution(*currentMap);
+        }
 
-            // nce ulalm hedefleri gncelle
-            for (const auto& agent : currentMap->agents) {
-                if (agent.reachedTarget) {
-                    currentMap->occupiedTargets.insert(agent.targetPos);
-                }
-            }
+        // The timesteps due since the last frame of a running simulation; after
+        // a stall it catches up at most a quarter of a second
+        const sf::Time elapsed = clock.restart();
+        const bool stepping = state == MAP_VIEW && currentMap && currentMap->simulationRunning;
+        stepTime = stepping ? std::min(stepTime + elapsed, sf::seconds(0.25f) + stepInterval) : sf::Time();
+        int dueSteps = 0;
+        for (; stepTime >= stepInterval; stepTime -= stepInterval) ++dueSteps;
 
-            for (auto& agent : currentMap->agents) {
-                if (!agent.reachedTarget) {
-                    agent.moveAlongPath(currentMap->occupiedTargets);
-                    agent.updatePosition(currentMap->offset.x, currentMap->offset.y);
-                    allReached = false;
-                }
-            }
+        if (state == MAP_VIEW && currentMap && currentMap->simulationRunning && currentMap->lifelong) {
+            for (int i = 0; i < dueSteps; ++i) stepLifelong(*currentMap);
+        }
+        else if (state == MAP_VIEW && currentMap && currentMap->simulationRunning) {
+            PlanExecutor& executor = *currentMap->executor;
+            for (int i = 0; i < dueSteps && !executor.isFinished(); ++i) executor.step();
 
-            if (allReached && !currentMap->allAgentsReached) {
+            if (executor.isFinished() && !currentMap->allAgentsReached) {
                 currentMap->simulationRunning = false;
                 currentMap->allAgentsReached = true;
                 currentMap->completionTime = currentMap->timer.getElapsedTime().asSeconds();
 
+                const ExecutionMetrics& metrics = executor.getMetrics();
+                if (!metrics.matchesPlan(currentMap->agents.size())) {
+                    std::cout << "Execution left the plan: " << currentMap->agents.size() - metrics.arrivedAgents
+                        << " agents short of their targets, " << metrics.deviations << " deviations, "
+                        << metrics.vertexCollisions + metrics.edgeCollisions << " collisions" << std::endl;
+                }
+
                 // Save result to file
                 saveResultToFile(currentMap->mapName, currentMap->selectedAlgorithm,
-                    currentMap->completionTime, currentMap->agents.size());
+                    currentMap->completionTime, currentMap->agents.size(), metrics);
             }
         }
 
@@ -870,8 +1009,10 @@ int main() {
             window.draw(algorithmLabel);
             window.draw(cbsBtn);
             window.draw(ictsBtn);
+            window.draw(ecbsBtn);
             window.draw(cbsText);
             window.draw(ictsText);
+            window.draw(ecbsText);
 
             // Arka planlar iz
             window.draw(map1Bg);
@@ -889,31 +1030,52 @@ int main() {
             window.draw(map3Btn);
         }
         else if (state == MAP_VIEW && currentMap) {
-            // Draw tiles
-            for (const auto& tile : currentMap->tiles) window.draw(tile);
-
-            // Draw targets
-            for (const auto& target : currentMap->targets) window.draw(target.shape);
-
-            // Draw agents
-            for (const auto& agent : currentMap->agents) window.draw(agent.shape);
+            // Draw tiles, then targets and agents
+            window.draw(currentMap->tiles);
+            buildMarkerLayer(*currentMap);
+            window.draw(currentMap->markers);
 
             // Draw back button
             window.draw(backBtn);
 
             // Draw algorithm info
-            std::string algName = (currentMap->selectedAlgorithm == CBS) ? "CBS" : "ICTS";
+            std::string algName = algorithmName(currentMap->selectedAlgorithm);
             algorithmText.setString("Algorithm: " + algName);
             window.draw(algorithmText);
 
-            // Draw timer
-            if (currentMap->simulationRunning) {
+            // Draw timer, or the search progress while planning
+            if (currentMap->planning) {
+                const SearchControl& control = currentMap->planControl;
+                std::string progress = "Planning... " + std::string(
+                    currentMap->selectedAlgorithm == ICTS ? "ICT" : "CT") + " nodes: " +
+                    std::to_string(control.nodesExpanded.load()) +
+                    ", cost bound: " + std::to_string(control.costBound.load());
+                if (control.conflicts.load() >= 0) {
+                    progress += ", conflicts: " + std::to_string(control.conflicts.load());
+                }
+                timerText.setString(progress);
+            }
+            else if (currentMap->lifelong) {
+                double last, mean, worst;
+                replanLatency(*currentMap->lifelongPlanner, last, mean, worst);
+                std::ostringstream status;
+                status << std::fixed << std::setprecision(1) << "Step " << currentMap->lifelongPlanner->getTimestep()
+                    << ", tasks: " << currentMap->tasksCompleted << ", replan: " << last << " ms (mean "
+                    << mean << ", max " << worst << ")";
+                timerText.setString(status.str());
+            }
+            else if (currentMap->simulationRunning) {
                 float seconds = currentMap->timer.getElapsedTime().asSeconds();
-                timerText.setString("Time: " + std::to_string(seconds) + " s");
+                timerText.setString("Step " + std::to_string(currentMap->executor->getMetrics().timesteps) +
+                    ", time: " + std::to_string(seconds) + " s");
             }
             else if (currentMap->allAgentsReached) {
-                timerText.setString("All agents reached to goal. Time: " +
-                    std::to_string(currentMap->completionTime) + " s");
+                const ExecutionMetrics& metrics = currentMap->executor->getMetrics();
+                timerText.setString((currentMap->executor->allArrived() ? "All agents reached to goal. " : "Agents stuck. ") +
+                    std::string("Makespan: ") + std::to_string(metrics.timesteps) +
+                    ", sum of costs: " + std::to_string(metrics.sumOfCosts) +
+                    ", waits: " + std::to_string(metrics.waits) +
+                    ", time: " + std::to_string(currentMap->completionTime) + " s");
             }
             window.draw(timerText);
         }
@@ -921,5 +1083,6 @@ int main() {
         window.display();
     }
 
+    if (state == MAP_VIEW && currentMap && currentMap->lifelong) printLifelongSummary(*currentMap);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,577 @@
+// Headless benchmark runner: solves MovingAI scenarios with the planners of
+// CreatingAMap and writes one record per (scenario, algorithm, agent count).
+// It does not depend on SFML. Built with MAPF_PROFILE, the JSON records also
+// hold each instance's profile (see Profiling.h). With --generate it writes
+// reproducible random scenarios for the map instead.
+
+#include "MapfTypes.h"
+#include "Grid.h"
+#include "MovingAI.h"
+#include "MapCache.h"
+#include "HeuristicCache.h"
+#include "Solvers.h"
+#include "ConflictDetector.h"
+#include "ThreadPool.h"
+#include "Profiling.h"
+#include "ScenarioGenerator.h"
+#include "TrajectoryFile.h"
+#include "PlanExecutor.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+
+namespace {
+    struct BenchOptions {
+        std::string mapFile;
+        std::vector<std::string> scenarioFiles;
+        std::vector<Algorithm> algorithms;
+        std::vector<int> agentCounts;
+        double timeoutSeconds = 60.0;
+        int jobs = 1;
+        int solverThreads = 1;
+        double suboptimality = 1.2;
+        std::string format = "csv";
+        std::string outputFile;  // stdout if empty
+        bool useMapCache = true;
+        bool persistTables = false;
+        bool prioritizeConflicts = true;
+        bool bypass = true;
+        bool rectangleReasoning = false;
+        bool corridorReasoning = true;
+        bool independenceDetection = false;
+        unsigned seed = 0;
+        int neighborhoodSize = 8;
+        Neighborhood neighborhood = ADAPTIVE_NEIGHBORHOOD;
+        bool cbsReplanning = false;
+        std::string curveFile;   // Cost-over-time of the anytime solvers; not written if empty
+        std::string snapshotFile;  // Profiles of the running instances; not written if empty
+        std::string trajectoryDir;   // Solutions as trajectory files; not written if empty
+        double snapshotInterval = 1.0;
+        int generateCount = 0;     // Scenarios to generate instead of solving
+        std::string scenarioPrefix;  // Of the generated files; the map path without extension if empty
+    };
+
+    struct BenchInstance {
+        int scenario;  // Index into the loaded scenarios
+        Algorithm algorithm;
+        int numAgents;
+    };
+
+    struct BenchRecord {
+        BenchInstance instance;
+        SolverResult result;
+        bool valid;
+        bool timedOut;
+        ExecutionMetrics execution;  // Of the solution, executed step by step
+        ProfileSnapshot profile;
+    };
+
+    void printUsage(std::ostream& out) {
+        out << "Usage: MapfBench --map FILE --scen FILE [--scen FILE ...]\n"
+            << "                 [--algorithms CBS,ICTS,ECBS,PP,PBS,LNS] [--agents 5:50:5 | 5,10,20]\n"
+            << "                 [--timeout SECONDS] [--jobs N] [--threads N] [--w FACTOR]\n"
+            << "                 [--format csv|json] [--output FILE] [--no-cache] [--persist-tables]\n"
+            << "                 [--no-prioritize] [--no-bypass] [--no-corridor] [--rectangle] [--id]\n"
+            << "                 [--seed N] [--lns-size N] [--neighborhood KIND] [--lns-cbs] [--curve FILE]\n"
+            << "                 [--snapshots FILE] [--snapshot-interval SECONDS] [--trajectories DIR]\n"
+            << "       MapfBench --help\n"
+            << "  --timeout  per-instance time limit (default 60)\n"
+            << "  --jobs     instances solved in parallel (default: number of cores)\n"
+            << "  --threads  threads used by each solver (default 1)\n"
+            << "  --w        suboptimality factor of ECBS (default 1.2)\n"
+            << "  --no-cache         parse the text map instead of its binary cache\n"
+            << "  --persist-tables   store the goals' distance tables in the map cache and share them\n"
+            << "  --no-prioritize, --no-bypass, --no-corridor\n"
+            << "                     turn off one of the CBS improvements\n"
+            << "  --rectangle        turn on rectangle reasoning in CBS (off by default)\n"
+            << "  --id               solve independent groups of agents separately\n"
+            << "  --seed       seed of the randomized solvers (PP restarts, LNS) and of --generate\n"
+            << "  --lns-size   agents LNS replans at once (default 8)\n"
+            << "  --neighborhood random|agent|intersection|adaptive  how LNS picks them (default adaptive)\n"
+            << "  --lns-cbs    replan LNS neighbourhoods with CBS instead of prioritized planning\n"
+            << "  --curve      write the sum of costs over time of every LNS run to FILE (CSV)\n"
+            << "  --snapshots  append the profile of every running instance to FILE (JSON lines)\n"
+            << "               every --snapshot-interval seconds (default 1); needs a MAPF_PROFILE build\n"
+            << "  --trajectories  store every solution in DIR as SCENARIO-ALGORITHM-AGENTS.traj\n"
+            << "       MapfBench --map FILE --generate COUNT [--agents N] [--seed N] [--jobs N] [--scen-prefix PREFIX]\n"
+            << "  --generate     write COUNT random scenarios of N agents (the largest --agents count) as\n"
+            << "                 PREFIX-random-1.scen ...; the same --seed gives the same files\n";
+    }
+
+    std::vector<std::string> split(const std::string& text, char separator) {
+        std::vector<std::string> parts;
+        std::stringstream stream(text);
+        std::string part;
+        while (std::getline(stream, part, separator)) {
+            if (!part.empty()) parts.push_back(part);
+        }
+        return parts;
+    }
+
+    // "first:last:step" or a comma-separated list
+    bool parseAgentCounts(const std::string& text, std::vector<int>& counts) {
+        std::vector<std::string> range = split(text, ':');
+        if (range.size() == 2 || range.size() == 3) {
+            int first = std::atoi(range[0].c_str());
+            int last = std::atoi(range[1].c_str());
+            int step = range.size() == 3 ? std::atoi(range[2].c_str()) : 1;
+            if (first <= 0 || step <= 0) return false;
+            for (int n = first; n <= last; n += step) counts.push_back(n);
+        }
+        else {
+            for (const auto& value : split(text, ',')) {
+                int n = std::atoi(value.c_str());
+                if (n <= 0) return false;
+                counts.push_back(n);
+            }
+        }
+        return !counts.empty();
+    }
+
+    bool parseArguments(int argc, char* argv[], BenchOptions& options) {
+        options.jobs = std::max(1u, std::thread::hardware_concurrency());
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--no-cache") {
+                options.useMapCache = false;
+                continue;
+            }
+            if (arg == "--persist-tables") {
+                options.persistTables = true;
+                continue;
+            }
+            if (arg == "--id") {
+                options.independenceDetection = true;
+                continue;
+            }
+            if (arg == "--lns-cbs") {
+                options.cbsReplanning = true;
+                continue;
+            }
+            if (arg == "--no-prioritize" || arg == "--no-bypass" || arg == "--no-corridor") {
+                if (arg == "--no-prioritize") options.prioritizeConflicts = false;
+                else if (arg == "--no-bypass") options.bypass = false;
+                else options.corridorReasoning = false;
+                continue;
+            }
+            if (arg == "--rectangle" || arg == "--no-rectangle") {
+                options.rectangleReasoning = arg == "--rectangle";
+                continue;
+            }
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return false;
+            }
+            std::string value = argv[++i];
+            if (arg == "--map") options.mapFile = value;
+            else if (arg == "--scen") options.scenarioFiles.push_back(value);
+            else if (arg == "--timeout") options.timeoutSeconds = std::atof(value.c_str());
+            else if (arg == "--jobs") options.jobs = std::max(1, std::atoi(value.c_str()));
+            else if (arg == "--threads") options.solverThreads = std::max(1, std::atoi(value.c_str()));
+            else if (arg == "--w") options.suboptimality = std::max(1.0, std::atof(value.c_str()));
+            else if (arg == "--format") options.format = value;
+            else if (arg == "--output") options.outputFile = value;
+            else if (arg == "--seed") options.seed = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+            else if (arg == "--lns-size") options.neighborhoodSize = std::max(2, std::atoi(value.c_str()));
+            else if (arg == "--curve") options.curveFile = value;
+            else if (arg == "--snapshots") options.snapshotFile = value;
+            else if (arg == "--trajectories") options.trajectoryDir = value;
+            else if (arg == "--snapshot-interval") options.snapshotInterval = std::max(0.01, std::atof(value.c_str()));
+            else if (arg == "--generate") options.generateCount = std::max(0, std::atoi(value.c_str()));
+            else if (arg == "--scen-prefix") options.scenarioPrefix = value;
+            else if (arg == "--neighborhood") {
+                if (value == "random") options.neighborhood = RANDOM_NEIGHBORHOOD;
+                else if (value == "agent") options.neighborhood = AGENT_NEIGHBORHOOD;
+                else if (value == "intersection") options.neighborhood = INTERSECTION_NEIGHBORHOOD;
+                else if (value == "adaptive") options.neighborhood = ADAPTIVE_NEIGHBORHOOD;
+                else {
+                    std::cerr << "Unknown neighborhood: " << value << std::endl;
+                    return false;
+                }
+            }
+            else if (arg == "--agents") {
+                if (!parseAgentCounts(value, options.agentCounts)) {
+                    std::cerr << "Invalid agent counts: " << value << std::endl;
+                    return false;
+                }
+            }
+            else if (arg == "--algorithms") {
+                for (const auto& name : split(value, ',')) {
+                    Algorithm algorithm;
+                    if (!parseAlgorithm(name, algorithm)) {
+                        std::cerr << "Unknown algorithm: " << name << std::endl;
+                        return false;
+                    }
+                    options.algorithms.push_back(algorithm);
+                }
+            }
+            else {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return false;
+            }
+        }
+
+        if (options.mapFile.empty() || (options.scenarioFiles.empty() && options.generateCount == 0)) return false;
+        if (options.format != "csv" && options.format != "json") {
+            std::cerr << "Unknown format: " << options.format << std::endl;
+            return false;
+        }
+        if (!options.snapshotFile.empty() && !PROFILING_ENABLED) {
+            std::cerr << "--snapshots needs a build with MAPF_PROFILE defined" << std::endl;
+            return false;
+        }
+        if (options.algorithms.empty()) options.algorithms = { CBS, ICTS };
+        if (options.agentCounts.empty()) parseAgentCounts("5:50:5", options.agentCounts);
+        return true;
+    }
+
+    std::string baseName(const std::string& path) {
+        size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+
+    std::string jsonString(const std::string& text) {
+        std::string quoted = "\"";
+        for (char c : text) {
+            if (c == '"' || c == '\\') quoted += '\\';
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    void writeCsv(std::ostream& out, const BenchOptions& options, const std::vector<BenchRecord>& records) {
+        out << "map,scenario,algorithm,agents,solved,valid,timed_out,runtime_s,sum_of_costs,lower_bound,makespan,"
+            << "high_level_expanded,high_level_generated,low_level_expanded,low_level_calls,"
+            << "cardinal,semi_cardinal,non_cardinal,bypasses,rectangles,corridors,groups,largest_group,"
+            << "neighborhoods,improvements,waits\n";
+        for (const auto& record : records) {
+            const SolverResult& result = record.result;
+            out << baseName(options.mapFile) << ','
+                << baseName(options.scenarioFiles[record.instance.scenario]) << ','
+                << algorithmName(record.instance.algorithm) << ','
+                << record.instance.numAgents << ','
+                << result.solved << ',' << record.valid << ',' << record.timedOut << ','
+                << result.stats.runtimeSeconds << ','
+                << result.sumOfCosts << ',' << result.lowerBound << ',' << result.makespan << ','
+                << result.stats.highLevelExpanded << ',' << result.stats.highLevelGenerated << ','
+                << result.stats.lowLevelExpanded << ',' << result.stats.lowLevelCalls << ','
+                << result.stats.cardinalConflicts << ',' << result.stats.semiCardinalConflicts << ','
+                << result.stats.nonCardinalConflicts << ',' << result.stats.bypasses << ','
+                << result.stats.rectangleSplits << ',' << result.stats.corridorSplits << ','
+                << result.stats.independentGroups << ',' << result.stats.largestGroup << ','
+                << result.stats.neighborhoods << ',' << result.stats.improvements << ','
+                << record.execution.waits << '\n';
+        }
+    }
+
+    void writeJson(std::ostream& out, const BenchOptions& options, const std::vector<BenchRecord>& records) {
+        out << "[\n";
+        for (size_t i = 0; i < records.size(); ++i) {
+            const BenchRecord& record = records[i];
+            const SolverResult& result = record.result;
+            out << "  {\"map\": " << jsonString(baseName(options.mapFile))
+                << ", \"scenario\": " << jsonString(baseName(options.scenarioFiles[record.instance.scenario]))
+                << ", \"algorithm\": " << jsonString(algorithmName(record.instance.algorithm))
+                << ", \"agents\": " << record.instance.numAgents
+                << ", \"solved\": " << (result.solved ? "true" : "false")
+                << ", \"valid\": " << (record.valid ? "true" : "false")
+                << ", \"timed_out\": " << (record.timedOut ? "true" : "false")
+                << ", \"runtime_s\": " << result.stats.runtimeSeconds
+                << ", \"sum_of_costs\": " << result.sumOfCosts
+                << ", \"lower_bound\": " << result.lowerBound
+                << ", \"makespan\": " << result.makespan
+                << ", \"high_level_expanded\": " << result.stats.highLevelExpanded
+                << ", \"high_level_generated\": " << result.stats.highLevelGenerated
+                << ", \"low_level_expanded\": " << result.stats.lowLevelExpanded
+                << ", \"low_level_calls\": " << result.stats.lowLevelCalls
+                << ", \"cardinal\": " << result.stats.cardinalConflicts
+                << ", \"semi_cardinal\": " << result.stats.semiCardinalConflicts
+                << ", \"non_cardinal\": " << result.stats.nonCardinalConflicts
+                << ", \"bypasses\": " << result.stats.bypasses
+                << ", \"rectangles\": " << result.stats.rectangleSplits
+                << ", \"corridors\": " << result.stats.corridorSplits
+                << ", \"groups\": " << result.stats.independentGroups
+                << ", \"largest_group\": " << result.stats.largestGroup
+                << ", \"neighborhoods\": " << result.stats.neighborhoods
+                << ", \"improvements\": " << result.stats.improvements
+                << ", \"waits\": " << record.execution.waits;
+            if (PROFILING_ENABLED) {
+                out << ", \"profile\": " << record.profile.toJson();
+            }
+            if (!result.costCurve.empty()) {
+                out << ", \"cost_curve\": [";
+                for (size_t k = 0; k < result.costCurve.size(); ++k) {
+                    out << (k > 0 ? ", " : "") << "[" << result.costCurve[k].seconds
+                        << ", " << result.costCurve[k].sumOfCosts << "]";
+                }
+                out << "]";
+            }
+            out << "}" << (i + 1 < records.size() ? "," : "") << "\n";
+        }
+        out << "]\n";
+    }
+
+    // One JSON line with the profile of a running instance
+    void writeSnapshot(std::ostream& out, const BenchOptions& options, const BenchInstance& instance,
+        double seconds, const ProfileSnapshot& profile) {
+        out << "{\"scenario\": " << jsonString(baseName(options.scenarioFiles[instance.scenario]))
+            << ", \"algorithm\": " << jsonString(algorithmName(instance.algorithm))
+            << ", \"agents\": " << instance.numAgents
+            << ", \"elapsed_s\": " << seconds
+            << ", \"profile\": " << profile.toJson() << "}\n";
+    }
+
+    // One row per improvement of an anytime solver
+    void writeCurves(std::ostream& out, const BenchOptions& options, const std::vector<BenchRecord>& records) {
+        out << "map,scenario,algorithm,agents,time_s,sum_of_costs\n";
+        for (const auto& record : records) {
+            for (const CostSample& sample : record.result.costCurve) {
+                out << baseName(options.mapFile) << ','
+                    << baseName(options.scenarioFiles[record.instance.scenario]) << ','
+                    << algorithmName(record.instance.algorithm) << ','
+                    << record.instance.numAgents << ','
+                    << sample.seconds << ',' << sample.sumOfCosts << '\n';
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(std::cout);
+            return 0;
+        }
+    }
+    BenchOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage(std::cerr);
+        return 1;
+    }
+
+    Grid grid;
+    MapCache mapCache;
+    if (options.useMapCache && mapCache.open(options.mapFile)) mapCache.loadGrid(grid);
+    else if (!loadGridFile(options.mapFile, grid)) return 1;
+
+    if (options.generateCount > 0) {
+        std::string prefix = options.scenarioPrefix;
+        if (prefix.empty()) {
+            size_t dot = options.mapFile.find_last_of('.');
+            size_t slash = options.mapFile.find_last_of("/\\");
+            if (slash != std::string::npos && dot != std::string::npos && dot < slash) dot = std::string::npos;
+            prefix = options.mapFile.substr(0, dot);
+        }
+        const int numAgents = *std::max_element(options.agentCounts.begin(), options.agentCounts.end());
+        ScenarioGenerator generator(grid);
+        const int written = writeRandomScenarios(generator, baseName(options.mapFile), prefix,
+            options.generateCount, numAgents, options.seed, options.jobs);
+        std::cerr << written << " scenarios of " << numAgents << " agents written to "
+            << prefix << "-random-*.scen" << std::endl;
+        return written == options.generateCount ? 0 : 1;
+    }
+
+    // Every instance of a scenario takes a prefix of its first 'maxAgents'
+    // entries, so they are parsed once; a malformed line stops the benchmark
+    const int maxAgents = *std::max_element(options.agentCounts.begin(), options.agentCounts.end());
+    std::vector<std::vector<ScenarioEntry>> scenarios;
+    for (const auto& filename : options.scenarioFiles) {
+        ScenarioFile scenario;
+        scenarios.emplace_back();
+        std::vector<ScenarioEntry>& entries = scenarios.back();
+        if (!scenario.open(filename) || !scenario.getEntries(maxAgents, entries)) return 1;
+        if (!entries.empty() && (entries[0].mapWidth != grid.getWidth() || entries[0].mapHeight != grid.getHeight())) {
+            std::cerr << "Warning: " << filename << " was made for a "
+                << entries[0].mapWidth << "x" << entries[0].mapHeight << " map" << std::endl;
+        }
+
+        // Found by component labels, so the solvers need not time out on them
+        std::vector<Position> starts, goals;
+        for (const auto& entry : entries) {
+            starts.push_back(entry.start);
+            goals.push_back(entry.goal);
+        }
+        const std::vector<int> unreachable = findUnreachableAgents(starts, goals, grid);
+        if (!unreachable.empty()) {
+            std::cerr << "Warning: " << unreachable.size() << " of the first " << entries.size() << " agents of "
+                << filename << " cannot reach their goals; instances with " << unreachable[0] + 1
+                << " or more agents fail at once" << std::endl;
+        }
+    }
+
+    // With persisted tables every goal of the benchmark is stored in the map
+    // cache up front, so all instances share mapped tables and none computes its own
+    std::unique_ptr<HeuristicCache> sharedHeuristics;
+    if (options.persistTables && mapCache.isOpen()) {
+        std::vector<int> goalCells;
+        for (const auto& entries : scenarios) {
+            for (const auto& entry : entries) {
+                if (grid.inBounds(entry.goal)) goalCells.push_back(grid.toId(entry.goal));
+            }
+        }
+        HeuristicCache builder(grid, 0);  // Computed tables go straight to the file
+        mapCache.storeTables(goalCells, builder);
+        sharedHeuristics.reset(new HeuristicCache(grid));
+        mapCache.preloadTables(*sharedHeuristics);
+        std::cerr << mapCache.getTableCount() << " distance tables in " << MapCache::cachePathFor(options.mapFile) << std::endl;
+    }
+
+    // Each instance takes the first n agents of a scenario
+    std::vector<BenchInstance> instances;
+    for (size_t s = 0; s < scenarios.size(); ++s) {
+        for (Algorithm algorithm : options.algorithms) {
+            for (int n : options.agentCounts) {
+                if (n > static_cast<int>(scenarios[s].size())) continue;
+                instances.push_back({ static_cast<int>(s), algorithm, n });
+            }
+        }
+    }
+
+    std::vector<BenchRecord> records(instances.size());
+    std::mutex logMutex;
+    int finished = 0;
+
+    // Every instance counts into its own profile. With --snapshots a writer
+    // thread dumps the profiles of the running instances at a fixed interval.
+    typedef std::chrono::steady_clock Clock;
+    std::vector<std::unique_ptr<SearchProfile>> profiles;
+    for (size_t i = 0; i < instances.size(); ++i) profiles.emplace_back(new SearchProfile());
+    std::vector<char> running(instances.size(), 0);
+    std::vector<Clock::time_point> startTimes(instances.size());
+    std::ofstream snapshots;
+    std::condition_variable benchFinished;
+    bool allFinished = false;
+    std::thread snapshotWriter;
+    if (!options.snapshotFile.empty()) {
+        snapshots.open(options.snapshotFile);
+        if (!snapshots.is_open()) {
+            std::cerr << "Cannot write " << options.snapshotFile << std::endl;
+            return 1;
+        }
+        snapshotWriter = std::thread([&]() {
+            const auto interval = std::chrono::duration<double>(options.snapshotInterval);
+            std::unique_lock<std::mutex> lock(logMutex);
+            while (!benchFinished.wait_for(lock, interval, [&]() { return allFinished; })) {
+                for (size_t i = 0; i < instances.size(); ++i) {
+                    if (!running[i]) continue;
+                    const double seconds = std::chrono::duration<double>(Clock::now() - startTimes[i]).count();
+                    writeSnapshot(snapshots, options, instances[i], seconds, profiles[i]->snapshot());
+                }
+                snapshots.flush();
+            }
+            });
+    }
+
+    {
+        ThreadPool pool(std::min(options.jobs, std::max(1, static_cast<int>(instances.size()))));
+        for (size_t i = 0; i < instances.size(); ++i) {
+            pool.submit([&, i]() {
+                const BenchInstance& instance = instances[i];
+                const std::vector<ScenarioEntry>& entries = scenarios[instance.scenario];
+                std::vector<Position> starts, goals;
+                for (int a = 0; a < instance.numAgents; ++a) {
+                    starts.push_back(entries[a].start);
+                    goals.push_back(entries[a].goal);
+                }
+
+                // Without persisted tables every instance pays for its own distance tables
+                SolveOptions solveOptions;
+                solveOptions.timeLimitSeconds = options.timeoutSeconds;
+                solveOptions.numThreads = options.solverThreads;
+                solveOptions.heuristics = sharedHeuristics.get();
+                solveOptions.suboptimality = options.suboptimality;
+                solveOptions.prioritizeConflicts = options.prioritizeConflicts;
+                solveOptions.bypass = options.bypass;
+                solveOptions.rectangleReasoning = options.rectangleReasoning;
+                solveOptions.corridorReasoning = options.corridorReasoning;
+                solveOptions.independenceDetection = options.independenceDetection;
+                solveOptions.seed = options.seed;
+                solveOptions.neighborhoodSize = options.neighborhoodSize;
+                solveOptions.neighborhood = options.neighborhood;
+                solveOptions.cbsReplanning = options.cbsReplanning;
+                // Instances already run in parallel; more group threads would only oversubscribe
+                solveOptions.groupThreads = options.jobs > 1 ? 1 : 0;
+                BenchRecord& record = records[i];
+                record.instance = instance;
+                {
+                    std::lock_guard<std::mutex> lock(logMutex);
+                    running[i] = 1;
+                    startTimes[i] = Clock::now();
+                }
+                {
+                    ProfileScope profileScope(profiles[i].get());
+                    record.result = solve(instance.algorithm, starts, goals, grid, solveOptions);
+                }
+                record.profile = profiles[i]->snapshot();
+                if (record.result.solved) {
+                    // A valid solution plays out exactly as planned
+                    AgentTable agents;
+                    agents.reserve(static_cast<int>(starts.size()));
+                    for (size_t a = 0; a < starts.size(); ++a) agents.add(starts[a], goals[a]);
+                    agents.setPaths(record.result.paths);
+                    PlanExecutor executor(grid, agents);
+                    executor.run();
+                    record.execution = executor.getMetrics();
+                }
+                record.valid = record.result.solved && !hasConflictsInPaths(record.result.paths, grid)
+                    && record.execution.matchesPlan(static_cast<int>(starts.size()));
+                record.timedOut = !record.result.solved && record.result.stats.runtimeSeconds >= options.timeoutSeconds;
+                if (record.result.solved && !options.trajectoryDir.empty()) {
+                    const std::string scenario = baseName(options.scenarioFiles[instance.scenario]);
+                    writeTrajectoryFile(options.trajectoryDir + "/" + scenario.substr(0, scenario.find_last_of('.')) + "-"
+                        + algorithmName(instance.algorithm) + "-" + std::to_string(instance.numAgents) + ".traj",
+                        grid.getWidth(), grid.getHeight(), starts, goals, record.result.paths);
+                }
+
+                std::lock_guard<std::mutex> lock(logMutex);
+                running[i] = 0;
+                std::cerr << "[" << ++finished << "/" << instances.size() << "] "
+                    << baseName(options.scenarioFiles[instance.scenario]) << " "
+                    << algorithmName(instance.algorithm) << " n=" << instance.numAgents << ": "
+                    << (record.result.solved ? "solved" : (record.timedOut ? "timeout" : "failed"))
+                    << " in " << record.result.stats.runtimeSeconds << " s" << std::endl;
+                });
+        }
+        pool.wait();
+    }
+    if (snapshotWriter.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(logMutex);
+            allFinished = true;
+        }
+        benchFinished.notify_all();
+        snapshotWriter.join();
+    }
+
+    std::ofstream file;
+    if (!options.outputFile.empty()) {
+        file.open(options.outputFile);
+        if (!file.is_open()) {
+            std::cerr << "Cannot write " << options.outputFile << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = options.outputFile.empty() ? std::cout : file;
+    if (options.format == "json") writeJson(out, options, records);
+    else writeCsv(out, options, records);
+
+    if (!options.curveFile.empty()) {
+        std::ofstream curves(options.curveFile);
+        if (!curves.is_open()) {
+            std::cerr << "Cannot write " << options.curveFile << std::endl;
+            return 1;
+        }
+        writeCurves(curves, options, records);
+    }
+    return 0;
+}